@@ -0,0 +1,168 @@
+// Compare node containers with the default allocator against the arena, pool and thread cached allocators.
+// Reports insert time, number of upstream (malloc) calls and the heap used relative to the bytes the container asked for.
+
+#include "../defines/tc_defines.h"
+
+#include "../time/tc_timer.h"
+#include "../random/tc_random_funcs.h"
+#include "../platform_info/platform_info.h"
+#include "tc_tracking_allocator.h"
+#include "tc_allocators.h"
+
+#include <unordered_set>
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+//! Bytes in use by malloc (heap and mmapped blocks), including its per allocation headers and padding.
+size_t get_heap_in_use() {const struct mallinfo2 mi = mallinfo2(); return mi.uordblks + mi.hblkhd;}
+#else
+size_t get_heap_in_use() {return 0;}
+#endif
+
+typedef TrackingAllocator<char> Upstream; // All the resources get their chunks through TrackingAllocator.
+
+const int num_inserts = 2000000;
+
+//! Destroyed during static destruction, after the main thread's cache; its blocks must go back to the central pool.
+std::vector<int, TCThreadCachedAllocator<int, Upstream>> global_vector;
+
+//! Results of filling one container.
+struct AllocResult
+{
+    double insert_time;
+    uint64_t num_upstream_allocations;
+    int64_t heap_bytes; //!< Signed, the heap may shrink while the container is filled.
+};
+
+//! Fill the container and measure before it is destroyed. The same seed is used for every container.
+template<class Container, class InsertFunc>
+AllocResult test_container(Container &container, InsertFunc insert_func)
+{
+    TCRandom<TC_MCG_Lehmer_RandFunc32> rng_keys(987654321);
+    AllocResult result;
+
+    const uint64_t num_allocations_before = TCAllocProfiler::get_num_allocations();
+    const size_t heap_before = get_heap_in_use();
+    const double start_time = TCTimer::get_time();
+
+    for (int i=0; i<num_inserts; ++i) insert_func(container, rng_keys.next());
+
+    result.insert_time = (TCTimer::get_time() - start_time) / num_inserts;
+    result.num_upstream_allocations = TCAllocProfiler::get_num_allocations() - num_allocations_before;
+    result.heap_bytes = int64_t(get_heap_in_use()) - int64_t(heap_before);
+    return result;
+}
+
+void print_result(const std::string &name, const AllocResult &result, const uint64_t requested_bytes)
+{
+    std::cout << "  " << name << ": insert " << result.insert_time << " s/call, "
+              << result.num_upstream_allocations << " upstream allocations, "
+              << result.heap_bytes / (1024*1024) << " MB heap, "
+              << double(result.heap_bytes) / requested_bytes << " x requested\n";
+    std::cout.flush();
+}
+
+//! Run one container type with each of the allocators.
+template<template<class> class ContainerOf, class InsertFunc>
+void test_allocators(const std::string &container_name, InsertFunc insert_func)
+{
+    std::cout << container_name << ":\n";
+    uint64_t requested_bytes = 0; // Live bytes the container asked for; the same for every allocator.
+    uint64_t num_allocations = 0;
+
+    {
+        // Counting pass only: the profiler bookkeeping would be charged to the baseline's insert time.
+        typename ContainerOf<TrackingAllocator<char>>::type container;
+        const uint64_t total_before = TCAllocProfiler::get_live_bytes();
+        num_allocations = test_container(container, insert_func).num_upstream_allocations;
+        requested_bytes = TCAllocProfiler::get_live_bytes() - total_before;
+    }
+    {
+        typename ContainerOf<std::allocator<char>>::type container;
+        AllocResult result = test_container(container, insert_func);
+        result.num_upstream_allocations = num_allocations;
+        print_result("std::allocator   ", result, requested_bytes);
+    }
+    {
+        TCArena<Upstream> arena;
+        typename ContainerOf<TCArenaAllocator<char, TCArena<Upstream>>>::type container(&arena);
+        print_result("TCArena          ", test_container(container, insert_func), requested_bytes);
+    }
+    {
+        TCPool<Upstream> pool;
+        typename ContainerOf<TCPoolAllocator<char, TCPool<Upstream>>>::type container(&pool);
+        print_result("TCPool           ", test_container(container, insert_func), requested_bytes);
+    }
+    {
+        // The central pool keeps its chunks, so this is only the growth beyond what earlier runs left behind.
+        typename ContainerOf<TCThreadCachedAllocator<char, Upstream>>::type container;
+        print_result("TCThreadCached   ", test_container(container, insert_func), requested_bytes);
+    }
+}
+
+//! The containers under test, parameterised on the allocator (of char; the containers rebind it).
+template<class Alloc>
+struct UnorderedSetOf
+{
+    struct type : std::unordered_set<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>,
+                                     typename std::allocator_traits<Alloc>::template rebind_alloc<uint32_t>>
+    {
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<uint32_t> A;
+        type() {}
+        template<class R> explicit type(R *resource) :
+        std::unordered_set<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, A>(10, std::hash<uint32_t>(), std::equal_to<uint32_t>(), A(resource)) {}
+    };
+};
+
+template<class Alloc>
+struct MapOf
+{
+    typedef std::pair<const uint32_t, uint32_t> V;
+    struct type : std::map<uint32_t, uint32_t, std::less<uint32_t>, typename std::allocator_traits<Alloc>::template rebind_alloc<V>>
+    {
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<V> A;
+        type() {}
+        template<class R> explicit type(R *resource) :
+        std::map<uint32_t, uint32_t, std::less<uint32_t>, A>(std::less<uint32_t>(), A(resource)) {}
+    };
+};
+
+template<class Alloc>
+struct DequeOf
+{
+    struct type : std::deque<uint32_t, typename std::allocator_traits<Alloc>::template rebind_alloc<uint32_t>>
+    {
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<uint32_t> A;
+        type() {}
+        template<class R> explicit type(R *resource) : std::deque<uint32_t, A>(A(resource)) {}
+    };
+};
+
+//! Insert functors. Templates, because each allocator gives a different container type.
+struct SetInsert {template<class C> void operator()(C &c, const uint32_t key) const {c.insert(key);}};
+struct MapInsert {template<class C> void operator()(C &c, const uint32_t key) const {c.emplace(key, key);}};
+struct DequePushPop { // Grow at the back and shrink at the front, so that blocks are freed and reused.
+    template<class C> void operator()(C &c, const uint32_t key) const {c.push_back(key); if ((key & 3) == 0) c.pop_front();}
+};
+
+int main(void)
+{
+    DBN(platform_info::get_cpu_brand_string())
+    DBN(platform_info::get_compiler())
+
+    const double EXP_TSC_FREQ = 2.89992e+09; // Doesn't really matter when using get_time() aot get_tsc_time().
+    TCTimer::init_timer(EXP_TSC_FREQ);
+
+    test_allocators<UnorderedSetOf>("unordered_set<uint32_t>", SetInsert());
+    test_allocators<MapOf>("map<uint32_t, uint32_t>", MapInsert());
+    test_allocators<DequeOf>("deque<uint32_t>", DequePushPop());
+
+    for (int i=0; i<100; ++i) global_vector.push_back(i);
+
+    return 0;
+}
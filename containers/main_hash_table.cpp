@@ -1,48 +1,38 @@
 // Analyse the heap allocations done by C++ unordered_set. unordered_map should behave similarly.
+// Then compare the memory, insert and lookup time of unordered_set against the open addressing TCFlatHashSet.
+// Finally, fill a mutex guarded unordered_set and a TCConcurrentHashSet from 1..N threads and report inserts/s.
 
 #include "../defines/tc_defines.h"
 
 #include "../time/tc_timer.h"
 #include "../random/tc_random_funcs.h"
 #include "../platform_info/platform_info.h"
+#include "tc_tracking_allocator.h"
+#include "tc_flat_hash_table.h"
+#include "tc_concurrent_hash_set.h"
 
 #include <map>
 #include <unordered_set>
+#include <vector>
+#include <thread>
+#include <mutex>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 
 
-uint64_t tracked_allocator_total = 0; // Tracked total number of bytes currently allocated.
-std::map<size_t, int64_t> tracked_allocator_breakdown_alloc; // The total number of items allocated by size of type.
-std::map<size_t, int64_t> tracked_allocator_breakdown_dealloc; // The total number of items de-allocated by size of type.
-
-// Simple minimal custom allocator to track total bytes and breakdown of allocations.
-template<typename _Ty>
-struct TrackingAllocator
-{
-    typedef _Ty value_type;
-    static _Ty* allocate(std::size_t n)
-    {
-        //Code that runs every allocation
-        tracked_allocator_total += sizeof(_Ty) * n;
-        tracked_allocator_breakdown_alloc[sizeof(_Ty)] = tracked_allocator_breakdown_alloc[sizeof(_Ty)] + n;
-        return std::allocator<_Ty>{}.allocate(n);
-    }
-    
-    static void deallocate(_Ty* mem, std::size_t n)
-    {
-        //Code that runs every deallocation
-        tracked_allocator_total -= sizeof(_Ty) * n;
-        tracked_allocator_breakdown_dealloc[sizeof(_Ty)] = tracked_allocator_breakdown_dealloc[sizeof(_Ty)] + n;
-        std::allocator<_Ty>{}.deallocate(mem, n);
-    }
-};
+const int set_site = TCAllocProfiler::register_site("unordered_set"); // Allocation site tags.
+const int flat_set_site = TCAllocProfiler::register_site("flat_hash_set");
 
 std::unordered_set<uint32_t,
                    std::hash<uint32_t>,
                    std::equal_to<uint32_t>,
-                   TrackingAllocator<uint32_t>> s;
+                   TrackingAllocator<uint32_t>> s(0, std::hash<uint32_t>(), std::equal_to<uint32_t>(), TrackingAllocator<uint32_t>(set_site));
+
+TCFlatHashSet<uint32_t,
+              std::hash<uint32_t>,
+              std::equal_to<uint32_t>,
+              TrackingAllocator<uint32_t>> fs(std::hash<uint32_t>{}, std::equal_to<uint32_t>{}, TrackingAllocator<uint32_t>(flat_set_site));
 
 struct BucketItem
 {
@@ -51,6 +41,72 @@ struct BucketItem
     BucketItem *next_;
 };
 
+//! Time lookups of keys from a random stream with the given seed. Returns seconds per lookup.
+template<class Set>
+double test_lookups(const Set &set, const uint32_t seed, const int num_lookups)
+{
+    TCRandom<TC_MCG_Lehmer_RandFunc32> rng(seed);
+    uint64_t count_sink = 0;
+
+    const double start_time = TCTimer::get_time();
+    for (int i=0; i<num_lookups; ++i) count_sink += set.count(rng.next());
+    const double end_time = TCTimer::get_time();
+
+    DBN(count_sink)
+    return (end_time - start_time) / num_lookups;
+}
+
+//! Run insert_func(rng) num_inserts/num_threads times on each of num_threads threads. Returns the wall time.
+template<class InsertFunc>
+double test_concurrent_inserts(const int num_threads, const int num_inserts, InsertFunc insert_func)
+{
+    std::vector<std::thread> threads;
+    const double start_time = TCTimer::get_time();
+
+    for (int t=0; t<num_threads; ++t)
+    {
+        threads.emplace_back([=]() {
+            TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321 + 7919 * t); // Own random stream per thread.
+            for (int i=0; i<(num_inserts / num_threads); ++i) insert_func(rng.next());
+        });
+    }
+
+    for (auto &thread : threads) thread.join();
+
+    return TCTimer::get_time() - start_time;
+}
+
+//! Thread scaling of a mutex guarded unordered_set vs TCConcurrentHashSet.
+void test_thread_scaling(const int num_inserts)
+{
+    const int max_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+
+    std::cout << "\nThread scaling (" << max_threads << " hardware threads):\n";
+
+    for (int num_threads=1; ; num_threads=std::min(num_threads * 2, max_threads))
+    {
+        std::unordered_set<uint32_t> locked_set;
+        std::mutex locked_set_mutex;
+        const double locked_time = test_concurrent_inserts(num_threads, num_inserts, [&](const uint32_t key) {
+            std::lock_guard<std::mutex> lock(locked_set_mutex);
+            locked_set.insert(key);
+        });
+
+        TCConcurrentHashSet<uint32_t> concurrent_set;
+        const double concurrent_time = test_concurrent_inserts(num_threads, num_inserts, [&](const uint32_t key) {
+            concurrent_set.insert(key);
+        });
+
+        const int num_done = (num_inserts / num_threads) * num_threads;
+        std::cout << num_threads << " threads: mutex + unordered_set " << num_done / locked_time << " inserts/s, "
+                  << "TCConcurrentHashSet " << num_done / concurrent_time << " inserts/s"
+                  << ((locked_set.size() == concurrent_set.size()) ? "" : " SIZE MISMATCH!") << "\n";
+        std::cout.flush();
+
+        if (num_threads == max_threads) break;
+    }
+}
+
 int main(void)
 {
     DBN(platform_info::get_cpu_brand_string())
@@ -75,6 +131,8 @@ int main(void)
     DBN(sizeof(s))
     DBN(s.max_load_factor())
 
+    TCAllocProfiler::set_sample_interval(100000); // Record the call stack of every 100000th allocation.
+
     std::cout << "Doing tests...";
     std::cout.flush();
     
@@ -87,20 +145,24 @@ int main(void)
         if (((i % 100000) == 0) ||
             (i == (num_iterations-1)) )
         {
+            const auto snapshot = TCAllocProfiler::get_snapshot();
+            const int64_t tracked_allocator_total = snapshot.live_bytes_; // Tracked total number of bytes currently allocated.
+            TCAllocProfiler::record_timeline_sample(TCTimer::get_time());
+
             DBS(TCTimer::get_time())
             DBS(s.load_factor())
             DBS(s.bucket_count())
             DBN(tracked_allocator_total/(1024*1024))
 
-            for (auto bd : tracked_allocator_breakdown_alloc)
+            for (int c=0; c<tc_alloc_profile::num_size_classes_; ++c)
             {
-                const auto type_size = bd.first; // The size of the allocated item.
-                
-                const auto number_alloc = bd.second; // The number of item allocations (of this size).
-                const auto number_dealloc = tracked_allocator_breakdown_dealloc[type_size];
-                const auto number_on_heap = number_alloc - number_dealloc; // Number of items of this type size that is currently on heap!
+                const auto number_alloc = snapshot.site_allocs_[set_site][c]; // The number of allocations of this size class.
+                if (number_alloc == 0) continue;
+
+                const auto size_class = uint64_t(1) << c; // Allocations of [size_class, 2*size_class) bytes.
+                const auto number_on_heap = number_alloc - snapshot.site_deallocs_[set_site][c]; // Number of allocations of this size class that is currently on heap!
 
-                DBS(type_size)
+                DBS(size_class)
                 DBS(number_alloc)
                 DBN(number_on_heap)
             }
@@ -127,5 +189,68 @@ int main(void)
     
     fout.close();
 
+    const double set_insert_time = end_time - start_time;
+    const uint64_t set_memory = TCAllocProfiler::get_live_bytes();
+    const double set_hit_time = test_lookups(s, 987654321, num_iterations); // Same seed, so all hits.
+    const double set_miss_time = test_lookups(s, 123456789, num_iterations); // Mostly misses.
+
+    // === Open addressing flat hash set ===
+    std::ofstream fout_flat("out_flat.csv");
+
+    fout_flat << "fs.size()" << ", ";
+    fout_flat << "TCTimer::get_time()" << ", ";
+    fout_flat << "tracked_allocator_total (MB)" << ", ";
+    fout_flat << "fs.load_factor()" << ", ";
+    fout_flat << "fs.capacity()" << "\n";
+
+    DBN(sizeof(fs))
+    std::cout << "Doing flat hash set tests...";
+    std::cout.flush();
+
+    TCRandom<TC_MCG_Lehmer_RandFunc32> rng_flat(987654321); // Same keys as above.
+    const uint64_t memory_before_flat = TCAllocProfiler::get_live_bytes();
+    start_time = TCTimer::get_time();
+
+    for (int i=0; i<num_iterations; ++i)
+    {
+        fs.insert(rng_flat.next());
+
+        if (((i % 100000) == 0) ||
+            (i == (num_iterations-1)) )
+        {
+            fout_flat << fs.size() << ", ";
+            fout_flat << TCTimer::get_time() << ", ";
+            fout_flat << (TCAllocProfiler::get_live_bytes() - memory_before_flat)/(1024*1024) << ", ";
+            TCAllocProfiler::record_timeline_sample(TCTimer::get_time());
+            fout_flat << fs.load_factor() << ", ";
+            fout_flat << fs.capacity() << "\n";
+        }
+    }
+
+    end_time = TCTimer::get_time();
+    fout_flat.close();
+    std::cout << "done.\n";
+
+    const double flat_insert_time = end_time - start_time;
+    const uint64_t flat_memory = TCAllocProfiler::get_live_bytes() - memory_before_flat;
+
+    TCAllocProfiler::write_timeline_csv("out_alloc_timeline.csv");
+    TCAllocProfiler::write_histogram_csv("out_alloc_histogram.csv");
+    TCAllocProfiler::write_stack_samples("out_alloc_stacks.txt");
+    const double flat_hit_time = test_lookups(fs, 987654321, num_iterations);
+    const double flat_miss_time = test_lookups(fs, 123456789, num_iterations);
+
+    DBN(fs.size())
+    DBN(fs.get_memory_usage()/(1024*1024))
+
+    std::cout << "\n";
+    std::cout << "unordered_set: " << set_memory/(1024*1024) << " MB, insert " << set_insert_time / num_iterations
+              << " s/call, hit " << set_hit_time << " s/call, miss " << set_miss_time << " s/call\n";
+    std::cout << "TCFlatHashSet: " << flat_memory/(1024*1024) << " MB, insert " << flat_insert_time / num_iterations
+              << " s/call, hit " << flat_hit_time << " s/call, miss " << flat_miss_time << " s/call\n";
+    std::cout.flush();
+
+    test_thread_scaling(num_iterations);
+
     return 0;
 }
@@ -1,20 +1,31 @@
-// Compare the performance of deque to vector.
+// Compare the performance of deque to vector and to the chunked TCSegmentedVector.
+// The sort test compares std::sort to the radix and parallel sample sorts of tc_sort.h.
+// The mapped test runs the vector test on the file backed TCMappedVector and times reopening the file.
+// The pages test fills and randomly updates the array with 4KB, transparent huge and explicit 2MB/1GB pages.
 
 #include "../defines/tc_defines.h"
 
 #include "../time/tc_timer.h"
 #include "../random/tc_random_funcs.h"
 #include "../platform_info/platform_info.h"
+#include "../platform_info/tc_huge_pages.h"
+#include "../platform_info/tc_perf_counter.h"
+#include "tc_segmented_vector.h"
+#include "tc_sort.h"
+#include "tc_mapped_vector.h"
 
 #include <deque>
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <string>
+#include <thread>
 
 
 TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321);
 std::deque<int> d;
 std::vector<int> v;
+TCSegmentedVector<int> sv;
 
 double vector_push_back = 0.0;
 double vector_push_front = 0.0;
@@ -28,6 +39,22 @@ double deque_sort = 0.0;
 double deque_iterate = 0.0;
 double deque_pop_back = 0.0;
 
+double segmented_push_back = 0.0;
+double segmented_push_front = 0.0;
+double segmented_sort = 0.0;
+double segmented_iterate = 0.0;
+double segmented_iterate_spans = 0.0;
+double segmented_pop_back = 0.0;
+double segmented_fifo = 0.0;
+size_t segmented_fifo_memory = 0;
+
+double mapped_push_back = 0.0;
+double mapped_sort = 0.0;
+double mapped_iterate = 0.0;
+double mapped_pop_back = 0.0;
+double mapped_reopen = 0.0;
+double mapped_sum_after_reopen = 0.0;
+
 
 void test_vector(const int num_iterations)
 {
@@ -172,7 +199,363 @@ void test_deque(const int num_iterations)
 }
 
 
-int main(void)
+void test_segmented(const int num_iterations)
+{
+    // == PUSH_BACK
+    {
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<(num_iterations>>1); ++i)
+        {
+            sv.push_back(rng.next());
+        }
+        
+        double end_time = TCTimer::get_time();
+        segmented_push_back = end_time - start_time;
+    }
+    
+    // == INSERT FRONT
+    {
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<(num_iterations>>1); ++i)
+        {
+            sv.push_front(rng.next());
+        }
+        
+        double end_time = TCTimer::get_time();
+        segmented_push_front = end_time - start_time;
+    }
+    
+    // == SORT
+    {
+        double start_time = TCTimer::get_time();
+        
+        sv.sort(); // Chunk aware sort.
+        
+        double end_time = TCTimer::get_time();
+        segmented_sort = end_time - start_time;
+    }
+    
+    // == ITERATE
+    {
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<num_iterations; ++i)
+        {
+            sv[i] = 2;
+        }
+        
+        double end_time = TCTimer::get_time();
+        segmented_iterate = end_time - start_time;
+    }
+    
+    // == ITERATE SPANS
+    {
+        double start_time = TCTimer::get_time();
+        
+        sv.for_each_span([](int *p, const size_t n) {
+            for (size_t i=0; i<n; ++i) p[i] = 3;
+        });
+        
+        double end_time = TCTimer::get_time();
+        segmented_iterate_spans = end_time - start_time;
+    }
+    
+    // == POP BACK
+    {
+        double start_time = TCTimer::get_time();
+        int number_sink = 0;
+        
+        for (int i=0; i<(num_iterations>>1); ++i)
+        {
+            number_sink += sv.back();
+            sv.pop_back();
+        }
+        
+        DBN(number_sink)
+        double end_time = TCTimer::get_time();
+        segmented_pop_back = end_time - start_time;
+    }
+    
+    // == FIFO: push_back/pop_front at a steady size must reuse the chunks emptied at the front.
+    {
+        TCSegmentedVector<int> fifo;
+        for (int i=0; i<1000; ++i) fifo.push_back(i);
+        
+        double start_time = TCTimer::get_time();
+        int number_sink = 0;
+        
+        for (int i=0; i<(num_iterations>>1); ++i)
+        {
+            fifo.push_back(rng.next());
+            number_sink += fifo.front();
+            fifo.pop_front();
+        }
+        
+        DBN(number_sink)
+        double end_time = TCTimer::get_time();
+        segmented_fifo = end_time - start_time;
+        segmented_fifo_memory = fifo.get_memory_usage();
+        
+        if (fifo.get_num_chunk_slots() > 4)
+        {
+            std::cout << "FIFO use grew the chunk map to " << fifo.get_num_chunk_slots() << " chunks!\n";
+        }
+    }
+}
+
+
+void test_mapped(const int num_iterations, const std::string &filename)
+{
+    TCMappedVector<int> mv;
+    
+    if (!mv.open(filename, true))
+    {
+        std::cout << "Could not open " << filename << "!\n";
+        return;
+    }
+    
+    // == PUSH_BACK
+    {
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<num_iterations; ++i)
+        {
+            mv.push_back(rng.next());
+        }
+        
+        double end_time = TCTimer::get_time();
+        mapped_push_back = end_time - start_time;
+    }
+    
+    // == SORT
+    {
+        mv.advise(TCMappedVector<int>::Access::random);
+        double start_time = TCTimer::get_time();
+        
+        std::sort(mv.begin(), mv.end());
+        
+        double end_time = TCTimer::get_time();
+        mapped_sort = end_time - start_time;
+    }
+    
+    // == ITERATE
+    {
+        mv.advise(TCMappedVector<int>::Access::sequential);
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<num_iterations; ++i)
+        {
+            mv[i] = 2;
+        }
+        
+        double end_time = TCTimer::get_time();
+        mapped_iterate = end_time - start_time;
+    }
+    
+    // == POP BACK
+    {
+        double start_time = TCTimer::get_time();
+        int number_sink = 0;
+        
+        for (int i=0; i<(num_iterations>>1); ++i)
+        {
+            number_sink += mv.back();
+            mv.pop_back();
+        }
+        
+        DBN(number_sink)
+        double end_time = TCTimer::get_time();
+        mapped_pop_back = end_time - start_time;
+    }
+    
+    // == REOPEN (no reload or parse; pages are faulted in from the page cache/disk when touched)
+    {
+        mv.close();
+        double start_time = TCTimer::get_time();
+        
+        mv.open(filename);
+        
+        double end_time = TCTimer::get_time();
+        mapped_reopen = end_time - start_time;
+        DBN(mv.size())
+    }
+    
+    // == SUM AFTER REOPEN
+    {
+        mv.advise(TCMappedVector<int>::Access::sequential);
+        double start_time = TCTimer::get_time();
+        int64_t sum = 0;
+        
+        for (const int x : mv) sum += x;
+        
+        DBN(sum)
+        double end_time = TCTimer::get_time();
+        mapped_sum_after_reopen = end_time - start_time;
+    }
+}
+
+
+//! Print a perf count, or n/a if the counter isn't available (e.g. in a VM).
+std::string perf_count_string(const TCPerfCounter &counter, const uint64_t count)
+{
+    return counter.is_available() ? std::to_string(count) : std::string("n/a");
+}
+
+void test_pages(const int num_iterations)
+{
+    using namespace tc_huge_pages;
+    const int num_random_updates = num_iterations / 4;
+    
+    DBN(get_num_numa_nodes())
+    
+    for (const PageKind kind : {PageKind::small, PageKind::transparent_huge, PageKind::huge_2mb, PageKind::huge_1gb})
+    {
+        TCHugePageBuffer<int> buffer(num_iterations, kind, NumaPolicy::interleave);
+        TCPerfCounter page_faults(TCPerfCounter::Event::page_faults);
+        TCPerfCounter dtlb_load_misses(TCPerfCounter::Event::dtlb_load_misses);
+        TCPerfCounter dtlb_store_misses(TCPerfCounter::Event::dtlb_store_misses);
+        
+        // == FILL (first touch)
+        page_faults.start();
+        double start_time = TCTimer::get_time();
+        
+        for (int i=0; i<num_iterations; ++i)
+        {
+            buffer[i] = rng.next();
+        }
+        
+        const double fill_time = TCTimer::get_time() - start_time;
+        const uint64_t fill_page_faults = page_faults.stop();
+        
+        // == RANDOM UPDATES
+        TCRandom<TC_MCG_Lehmer_RandFunc32> rng_index(123456789);
+        dtlb_load_misses.start();
+        dtlb_store_misses.start();
+        start_time = TCTimer::get_time();
+        
+        for (int i=0; i<num_random_updates; ++i)
+        {
+            buffer[rng_index.next(num_iterations)] += i;
+        }
+        
+        const double random_time = TCTimer::get_time() - start_time;
+        const uint64_t random_dtlb_load_misses = dtlb_load_misses.stop();
+        const uint64_t random_dtlb_store_misses = dtlb_store_misses.stop();
+        
+        std::cout << get_page_kind_name(kind) << " requested, " << get_page_kind_name(buffer.get_page_kind()) << " used"
+                  << (buffer.is_numa_policy_applied() ? " (interleaved)" : "") << ": "
+                  << "fill " << fill_time << " s, " << perf_count_string(page_faults, fill_page_faults) << " page faults; "
+                  << "random updates " << random_time / num_random_updates << " s/call, "
+                  << perf_count_string(dtlb_load_misses, random_dtlb_load_misses) << " dTLB load misses, "
+                  << perf_count_string(dtlb_store_misses, random_dtlb_store_misses) << " dTLB store misses\n";
+        std::cout.flush();
+    }
+}
+
+
+//! Input orders for the sort test.
+enum class SortInput {random, sorted, few_unique};
+
+template<class T>
+void fill_sort_input(std::vector<T> &input, const size_t n, const SortInput kind)
+{
+    TCRandom<TC_MCG_Lehmer_RandFunc32> rng_input(987654321);
+    input.resize(n);
+    
+    for (size_t i=0; i<n; ++i)
+    {
+        const uint64_t r = (uint64_t(rng_input.next()) << 32) | rng_input.next();
+        input[i] = (kind == SortInput::few_unique) ? T(r % 16) : T(r);
+    }
+    
+    if (kind == SortInput::sorted) std::sort(input.begin(), input.end());
+}
+
+//! Time one sort of a copy of the input. Returns the time per element.
+template<class T, class SortFunc>
+double time_sort(const std::vector<T> &input, std::vector<T> &work, SortFunc sort_func)
+{
+    work = input;
+    
+    double start_time = TCTimer::get_time();
+    sort_func(work);
+    double end_time = TCTimer::get_time();
+    
+    if (!std::is_sorted(work.begin(), work.end())) std::cout << "NOT SORTED!\n";
+    return (end_time - start_time) / input.size();
+}
+
+//! Sort n keys of type T with std::sort, radix_sort and parallel_sort for each input order.
+template<class T>
+void test_sort_keys(const std::string &type_name, const size_t n)
+{
+    const int num_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+    const char * const input_names[] = {"random", "sorted", "few_unique"};
+    std::vector<T> input, work;
+    
+    for (const SortInput kind : {SortInput::random, SortInput::sorted, SortInput::few_unique})
+    {
+        fill_sort_input(input, n, kind);
+        
+        const double std_sort = time_sort(input, work, [](std::vector<T> &w) {std::sort(w.begin(), w.end());});
+        const double radix_sort = time_sort(input, work, [](std::vector<T> &w) {tc_sort::radix_sort(w.data(), w.size());});
+        const double parallel_sort = time_sort(input, work, [num_threads](std::vector<T> &w) {
+            tc_sort::parallel_sort(w.data(), w.size(), num_threads);
+        });
+        
+        std::cout << type_name << " " << input_names[int(kind)] << " (" << n << " keys, " << num_threads << " threads): "
+                  << "std::sort " << std_sort << " s/key, "
+                  << "radix_sort " << radix_sort << " s/key, "
+                  << "parallel_sort " << parallel_sort << " s/key\n";
+        std::cout.flush();
+    }
+}
+
+//! Sort n (key, index) pairs: std::sort of a vector of pairs vs. radix_sort_pairs of separate key and value arrays.
+void test_sort_pairs(const size_t n)
+{
+    std::vector<uint32_t> keys;
+    fill_sort_input(keys, n, SortInput::random);
+    
+    std::vector<std::pair<uint32_t, uint32_t>> pairs(n);
+    for (size_t i=0; i<n; ++i) pairs[i] = std::make_pair(keys[i], uint32_t(i));
+    
+    double start_time = TCTimer::get_time();
+    std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<uint32_t, uint32_t> &a, const std::pair<uint32_t, uint32_t> &b) {
+        return a.first < b.first;
+    });
+    const double std_stable_sort = (TCTimer::get_time() - start_time) / n;
+    
+    std::vector<uint32_t> values(n);
+    for (size_t i=0; i<n; ++i) values[i] = uint32_t(i);
+    
+    start_time = TCTimer::get_time();
+    tc_sort::radix_sort_pairs(keys.data(), values.data(), n);
+    const double radix_sort_pairs = (TCTimer::get_time() - start_time) / n;
+    
+    bool same = true; // Both sorts are stable, so the results must be identical.
+    for (size_t i=0; i<n; ++i) same = same && (pairs[i].first == keys[i]) && (pairs[i].second == values[i]);
+    if (!same) std::cout << "PAIRS DIFFER!\n";
+    
+    std::cout << "uint32_t pairs random (" << n << " pairs): "
+              << "std::stable_sort " << std_stable_sort << " s/pair, "
+              << "radix_sort_pairs " << radix_sort_pairs << " s/pair\n";
+    std::cout.flush();
+}
+
+void test_sort(const int num_iterations)
+{
+    test_sort_keys<int>("int", num_iterations);
+    
+    // 64-bit keys and pairs need twice the memory, so use fewer elements.
+    test_sort_keys<int64_t>("int64_t", num_iterations / 4);
+    test_sort_pairs(num_iterations / 4);
+}
+
+
+int main(int argc, char *argv[])
 {
     DBN(platform_info::get_cpu_brand_string())
     DBN(platform_info::get_compiler())
@@ -186,9 +569,21 @@ int main(void)
     std::cout << "Doing tests...";
     std::cout.flush();
 
-    //Note: Only do one test at a time! Either test_vector OR test_deque.
-    test_vector(num_iterations);
-    //test_deque(num_iterations);
+    //Note: Only do one test at a time! Either test_vector, test_deque, test_segmented, test_mapped, test_sort OR test_pages.
+    const std::string test_name = (argc > 1) ? argv[1] : "vector"; // vector, deque, segmented, mapped, sort or pages.
+
+    if ((test_name == "sort") || (test_name == "pages"))
+    {
+        std::cout << "\n";
+        if (test_name == "sort") test_sort(num_iterations);
+        else test_pages(num_iterations);
+        return 0;
+    }
+    
+    if (test_name == "deque") test_deque(num_iterations);
+    else if (test_name == "segmented") test_segmented(num_iterations);
+    else if (test_name == "mapped") test_mapped(num_iterations, (argc > 2) ? argv[2] : "vector_vs_deque.bin");
+    else test_vector(num_iterations);
     
     std::cout << "done.\n";
 
@@ -204,5 +599,21 @@ int main(void)
     DBN(deque_iterate)
     DBN(deque_pop_back)
 
+    DBN(segmented_push_back)
+    DBN(segmented_push_front)
+    DBN(segmented_sort)
+    DBN(segmented_iterate)
+    DBN(segmented_iterate_spans)
+    DBN(segmented_pop_back)
+    DBN(segmented_fifo)
+    DBN(segmented_fifo_memory)
+
+    DBN(mapped_push_back)
+    DBN(mapped_sort)
+    DBN(mapped_iterate)
+    DBN(mapped_pop_back)
+    DBN(mapped_reopen)
+    DBN(mapped_sum_after_reopen)
+
     return 0;
 }
@@ -0,0 +1,461 @@
+#ifndef TC_ALLOCATORS_H
+#define TC_ALLOCATORS_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+//=============================//
+//=== TC Arena/Pool Allocs ====//
+//=============================//
+/*!
+ * Memory resources that replace the one heap allocation per node of node based containers, plus STL allocator
+ * adapters so they can be passed as the allocator template argument of std::unordered_set, std::map, std::deque, etc.
+ * - TCArena: monotonic bump allocator. deallocate is a no-op; everything is freed at once by release() or the dtor.
+ * - TCPool: free list per 16 byte size class up to max_pooled_size_, carved from large upstream chunks.
+ * - TCThreadCachedAllocator: per-thread free lists that move blocks to/from a shared central pool in batches, so
+ *   threads only take a lock once per batch. Blocks may be freed by another thread than the one that allocated them.
+ * Upstream is the allocator (of char) the chunks come from, e.g. TrackingAllocator<char> to count upstream calls.
+ * EXAMPLE Usage:
+ *   TCArena<> arena;
+ *   std::unordered_set<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, TCArenaAllocator<uint32_t>> s(10, std::hash<uint32_t>(), std::equal_to<uint32_t>(), TCArenaAllocator<uint32_t>(&arena));
+ *
+ *   TCPool<> pool;
+ *   std::map<int, int, std::less<int>, TCPoolAllocator<std::pair<const int, int>>> m(std::less<int>(), TCPoolAllocator<std::pair<const int, int>>(&pool));
+ *
+ *   std::deque<int, TCThreadCachedAllocator<int>> d; //Stateless.
+ */
+
+namespace tc_alloc {
+    constexpr size_t max_align_ = 16; //!< Alignment of all blocks handed out (alignof(max_align_t) on x86-64).
+
+    ALWAYS_INLINE size_t align_up(const size_t n, const size_t alignment) noexcept {
+        return (n + alignment - 1) & ~(alignment - 1);
+    }
+
+    //! 16 byte size classes: class i holds blocks of (i+1)*16 bytes. Zero bytes get the smallest class.
+    ALWAYS_INLINE size_t size_class(const size_t bytes) noexcept {return (bytes - (bytes != 0)) >> 4;}
+    ALWAYS_INLINE size_t class_size(const size_t size_class) noexcept {return (size_class + 1) << 4;}
+
+    constexpr size_t max_pooled_size_ = 1024; //!< Larger allocations go straight upstream.
+    constexpr size_t num_size_classes_ = max_pooled_size_ / 16;
+    constexpr size_t chunk_size_ = 64 * 1024; //!< Size of the upstream chunks that pools carve blocks from.
+
+    //! Intrusive free list node stored in a free block.
+    struct FreeBlock {
+        FreeBlock *next_;
+    };
+}
+
+//===
+
+//! Monotonic arena. Not thread safe.
+template<class Upstream = std::allocator<char>>
+class TCArena {
+public:
+    explicit TCArena(const size_t initial_block_size = tc_alloc::chunk_size_, const Upstream &upstream = Upstream()) :
+    upstream_(upstream), cur_(nullptr), end_(nullptr), next_block_size_(initial_block_size),
+    bytes_used_(0), bytes_reserved_(0), num_upstream_allocations_(0) {}
+
+    ~TCArena() {release();}
+
+    TCArena(const TCArena &) = delete;
+    TCArena &operator=(const TCArena &) = delete;
+
+    ALWAYS_INLINE void *allocate(const size_t bytes, const size_t alignment = tc_alloc::max_align_) {
+        size_t padding = tc_alloc::align_up(size_t(cur_), alignment) - size_t(cur_);
+
+        //Compares sizes, because before the first block cur_ and end_ are null and pointer arithmetic on them is UB.
+        if ((cur_ == nullptr) || ((padding + bytes) > size_t(end_ - cur_))) {
+            add_block(bytes + alignment);
+            padding = tc_alloc::align_up(size_t(cur_), alignment) - size_t(cur_);
+        }
+
+        char * const p = cur_ + padding;
+        cur_ = p + bytes;
+        bytes_used_ += bytes;
+        return p;
+    }
+
+    //! Memory is only returned by release().
+    ALWAYS_INLINE void deallocate(void *, const size_t) noexcept {}
+
+    //! Return all blocks to upstream.
+    void release() noexcept {
+        for (const auto &block : blocks_) upstream_.deallocate(block.first, block.second);
+        blocks_.clear();
+        cur_ = end_ = nullptr;
+        bytes_used_ = bytes_reserved_ = 0;
+    }
+
+    size_t get_bytes_used() const noexcept {return bytes_used_;}
+    size_t get_bytes_reserved() const noexcept {return bytes_reserved_;}
+    size_t get_num_upstream_allocations() const noexcept {return num_upstream_allocations_;}
+
+private:
+    //! Blocks double in size so that the number of upstream calls is logarithmic.
+    void add_block(const size_t min_bytes) {
+        const size_t block_size = std::max(next_block_size_, min_bytes);
+        cur_ = upstream_.allocate(block_size);
+        end_ = cur_ + block_size;
+        blocks_.push_back(std::make_pair(cur_, block_size));
+        next_block_size_ = std::min(block_size * 2, size_t(64) << 20);
+        bytes_reserved_ += block_size;
+        ++num_upstream_allocations_;
+    }
+
+    Upstream upstream_;
+    char *cur_;//!< Next free byte in the current block.
+    char *end_;//!< End of the current block.
+    size_t next_block_size_;
+    std::vector<std::pair<char *, size_t>> blocks_;
+
+    size_t bytes_used_;
+    size_t bytes_reserved_;
+    size_t num_upstream_allocations_;
+};
+
+//===
+
+//! Size class pool with free lists. Not thread safe.
+template<class Upstream = std::allocator<char>>
+class TCPool {
+public:
+    explicit TCPool(const Upstream &upstream = Upstream()) :
+    upstream_(upstream), bytes_used_(0), bytes_reserved_(0), num_upstream_allocations_(0) {
+        std::fill(free_lists_, free_lists_ + tc_alloc::num_size_classes_, nullptr);
+    }
+
+    ~TCPool() {release();}
+
+    TCPool(const TCPool &) = delete;
+    TCPool &operator=(const TCPool &) = delete;
+
+    ALWAYS_INLINE void *allocate(const size_t bytes) {
+        bytes_used_ += bytes;
+        if (bytes > tc_alloc::max_pooled_size_) return allocate_upstream(bytes);
+
+        const size_t c = tc_alloc::size_class(bytes);
+        tc_alloc::FreeBlock *block = free_lists_[c];
+        if (block == nullptr) block = refill(c);
+        free_lists_[c] = block->next_;
+        return block;
+    }
+
+    ALWAYS_INLINE void deallocate(void * const p, const size_t bytes) noexcept {
+        bytes_used_ -= bytes;
+
+        if (bytes > tc_alloc::max_pooled_size_) {
+            upstream_.deallocate((char *) p, bytes);
+            bytes_reserved_ -= bytes;
+            return;
+        }
+
+        const size_t c = tc_alloc::size_class(bytes);
+        tc_alloc::FreeBlock * const block = (tc_alloc::FreeBlock *) p;
+        block->next_ = free_lists_[c];
+        free_lists_[c] = block;
+    }
+
+    //! Return all chunks to upstream. Large allocations must already have been deallocated.
+    void release() noexcept {
+        for (char *chunk : chunks_) upstream_.deallocate(chunk, tc_alloc::chunk_size_);
+        bytes_reserved_ -= chunks_.size() * tc_alloc::chunk_size_;
+        chunks_.clear();
+        std::fill(free_lists_, free_lists_ + tc_alloc::num_size_classes_, nullptr);
+    }
+
+    size_t get_bytes_used() const noexcept {return bytes_used_;}
+    size_t get_bytes_reserved() const noexcept {return bytes_reserved_;}
+    size_t get_num_upstream_allocations() const noexcept {return num_upstream_allocations_;}
+
+private:
+    void *allocate_upstream(const size_t bytes) {
+        bytes_reserved_ += bytes;
+        ++num_upstream_allocations_;
+        return upstream_.allocate(bytes);
+    }
+
+    //! Carve a new chunk into blocks of size class c.
+    tc_alloc::FreeBlock *refill(const size_t c) {
+        char * const chunk = (char *) allocate_upstream(tc_alloc::chunk_size_);
+        chunks_.push_back(chunk);
+
+        const size_t block_size = tc_alloc::class_size(c);
+        const size_t num_blocks = tc_alloc::chunk_size_ / block_size;
+        tc_alloc::FreeBlock *head = nullptr;
+
+        for (size_t i=num_blocks; i>0; --i) {
+            tc_alloc::FreeBlock * const block = (tc_alloc::FreeBlock *) (chunk + (i - 1) * block_size);
+            block->next_ = head;
+            head = block;
+        }
+
+        return head;
+    }
+
+    Upstream upstream_;
+    tc_alloc::FreeBlock *free_lists_[tc_alloc::num_size_classes_];
+    std::vector<char *> chunks_;
+
+    size_t bytes_used_;
+    size_t bytes_reserved_;
+    size_t num_upstream_allocations_;
+};
+
+//===
+
+namespace tc_alloc {
+    //! Process wide pool behind TCThreadCachedAllocator. Blocks move in and out in batches of batch_size_.
+    template<class Upstream>
+    class CentralPool {
+    public:
+        static constexpr size_t batch_size_ = 64;
+
+        //! Never destroyed: containers with static storage duration free their blocks during static destruction.
+        static CentralPool &instance() {static CentralPool * const pool = new CentralPool; return *pool;}
+
+        //! Pop a batch of blocks of size class c. Returns the list head; the list is null terminated.
+        FreeBlock *pop_batch(const size_t c) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_lists_[c].empty()) refill(c);
+            FreeBlock * const head = free_lists_[c].back();
+            free_lists_[c].pop_back();
+            return head;
+        }
+
+        //! Push a null terminated list of blocks of size class c.
+        void push_batch(const size_t c, FreeBlock * const head) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_lists_[c].push_back(head);
+        }
+
+        void *allocate_large(const size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bytes_reserved_ += bytes;
+            ++num_upstream_allocations_;
+            return upstream_.allocate(bytes);
+        }
+
+        void deallocate_large(void * const p, const size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bytes_reserved_ -= bytes;
+            upstream_.deallocate((char *) p, bytes);
+        }
+
+        //! Single block allocate, for threads whose cache has already been destroyed.
+        void *allocate(const size_t bytes) {
+            if (bytes > max_pooled_size_) return allocate_large(bytes);
+
+            const size_t c = size_class(bytes);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_lists_[c].empty()) refill(c);
+            FreeBlock * const block = free_lists_[c].back();
+            if (block->next_ != nullptr) free_lists_[c].back() = block->next_;
+            else free_lists_[c].pop_back();
+            return block;
+        }
+
+        //! Single block deallocate, for threads whose cache has already been destroyed.
+        void deallocate(void * const p, const size_t bytes) {
+            if (bytes > max_pooled_size_) {
+                deallocate_large(p, bytes);
+                return;
+            }
+
+            FreeBlock * const block = (FreeBlock *) p;
+            block->next_ = nullptr;
+            push_batch(size_class(bytes), block);
+        }
+
+        size_t get_bytes_reserved() {std::lock_guard<std::mutex> lock(mutex_); return bytes_reserved_;}
+        size_t get_num_upstream_allocations() {std::lock_guard<std::mutex> lock(mutex_); return num_upstream_allocations_;}
+
+    private:
+        CentralPool() : bytes_reserved_(0), num_upstream_allocations_(0) {}
+
+        //! Carve a chunk into batches of blocks of size class c.
+        void refill(const size_t c) {
+            char * const chunk = upstream_.allocate(chunk_size_);
+            chunks_.push_back(chunk);
+            bytes_reserved_ += chunk_size_;
+            ++num_upstream_allocations_;
+
+            const size_t block_size = class_size(c);
+            const size_t num_blocks = chunk_size_ / block_size;
+
+            for (size_t b=0; b<num_blocks; b+=batch_size_) {
+                FreeBlock *head = nullptr;
+                for (size_t i=std::min(b + batch_size_, num_blocks); i>b; --i) {
+                    FreeBlock * const block = (FreeBlock *) (chunk + (i - 1) * block_size);
+                    block->next_ = head;
+                    head = block;
+                }
+                free_lists_[c].push_back(head);
+            }
+        }
+
+        Upstream upstream_;
+        std::mutex mutex_;
+        std::vector<FreeBlock *> free_lists_[num_size_classes_];//!< Batches per size class.
+        std::vector<char *> chunks_;
+
+        size_t bytes_reserved_;
+        size_t num_upstream_allocations_;
+    };
+
+    //! Per-thread free lists. Returns everything to the central pool when the thread exits.
+    template<class Upstream>
+    class ThreadCache {
+    public:
+        //! The calling thread's cache, or nullptr once it has been destroyed (thread exit, and for the main thread
+        //! before static destruction). Callers then go to the central pool directly.
+        ALWAYS_INLINE static ThreadCache *instance() {
+            ThreadState &state = thread_state();
+            if ((state.cache_ == nullptr) && !state.torn_down_) {
+                static thread_local ThreadCache cache;
+                state.cache_ = &cache;
+            }
+            return state.cache_;
+        }
+
+        ~ThreadCache() {
+            for (size_t c=0; c<num_size_classes_; ++c) {
+                while (lists_[c] != nullptr) push_batch(c);
+            }
+            thread_state().cache_ = nullptr;
+            thread_state().torn_down_ = true;
+        }
+
+        ALWAYS_INLINE void *allocate(const size_t bytes) {
+            if (bytes > max_pooled_size_) return CentralPool<Upstream>::instance().allocate_large(bytes);
+
+            const size_t c = size_class(bytes);
+            if (lists_[c] == nullptr) {
+                lists_[c] = CentralPool<Upstream>::instance().pop_batch(c);
+                counts_[c] = CentralPool<Upstream>::batch_size_; //Last batch of a chunk may be smaller; only a heuristic.
+            }
+
+            FreeBlock * const block = lists_[c];
+            lists_[c] = block->next_;
+            counts_[c] -= (counts_[c] > 0);
+            return block;
+        }
+
+        ALWAYS_INLINE void deallocate(void * const p, const size_t bytes) {
+            if (bytes > max_pooled_size_) {
+                CentralPool<Upstream>::instance().deallocate_large(p, bytes);
+                return;
+            }
+
+            const size_t c = size_class(bytes);
+            FreeBlock * const block = (FreeBlock *) p;
+            block->next_ = lists_[c];
+            lists_[c] = block;
+            if (++counts_[c] >= 2 * CentralPool<Upstream>::batch_size_) push_batch(c);
+        }
+
+    private:
+        //! Trivially destructible, so it can still be read after the thread's cache has been destroyed.
+        struct ThreadState {
+            ThreadCache *cache_;
+            bool torn_down_;
+        };
+
+        static ThreadState &thread_state() {static thread_local ThreadState state = {nullptr, false}; return state;}
+
+        ThreadCache() {
+            std::fill(lists_, lists_ + num_size_classes_, nullptr);
+            std::fill(counts_, counts_ + num_size_classes_, 0);
+        }
+
+        //! Move up to batch_size_ blocks of size class c to the central pool.
+        void push_batch(const size_t c) {
+            FreeBlock * const head = lists_[c];
+            FreeBlock *tail = head;
+            for (size_t i=1; (i<CentralPool<Upstream>::batch_size_) && (tail->next_ != nullptr); ++i) tail = tail->next_;
+
+            lists_[c] = tail->next_;
+            tail->next_ = nullptr;
+            counts_[c] = (counts_[c] > CentralPool<Upstream>::batch_size_) ? (counts_[c] - CentralPool<Upstream>::batch_size_) : 0;
+            CentralPool<Upstream>::instance().push_batch(c, head);
+        }
+
+        FreeBlock *lists_[num_size_classes_];
+        size_t counts_[num_size_classes_];
+    };
+
+    template<class Upstream> constexpr size_t CentralPool<Upstream>::batch_size_;
+}
+
+//===
+
+//! STL allocator adapter for TCArena.
+template<class T, class Arena = TCArena<>>
+struct TCArenaAllocator {
+    typedef T value_type;
+
+    explicit TCArenaAllocator(Arena * const arena) noexcept : arena_(arena) {}
+    template<class U> TCArenaAllocator(const TCArenaAllocator<U, Arena> &other) noexcept : arena_(other.arena_) {}
+
+    ALWAYS_INLINE T *allocate(const size_t n) {return (T *) arena_->allocate(n * sizeof(T), alignof(T));}
+    ALWAYS_INLINE void deallocate(T * const p, const size_t n) noexcept {arena_->deallocate(p, n * sizeof(T));}
+
+    Arena *arena_;
+};
+
+template<class T, class U, class Arena>
+bool operator==(const TCArenaAllocator<T, Arena> &a, const TCArenaAllocator<U, Arena> &b) {return a.arena_ == b.arena_;}
+template<class T, class U, class Arena>
+bool operator!=(const TCArenaAllocator<T, Arena> &a, const TCArenaAllocator<U, Arena> &b) {return a.arena_ != b.arena_;}
+
+//! STL allocator adapter for TCPool.
+template<class T, class Pool = TCPool<>>
+struct TCPoolAllocator {
+    typedef T value_type;
+
+    explicit TCPoolAllocator(Pool * const pool) noexcept : pool_(pool) {}
+    template<class U> TCPoolAllocator(const TCPoolAllocator<U, Pool> &other) noexcept : pool_(other.pool_) {}
+
+    ALWAYS_INLINE T *allocate(const size_t n) {return (T *) pool_->allocate(n * sizeof(T));}
+    ALWAYS_INLINE void deallocate(T * const p, const size_t n) noexcept {pool_->deallocate(p, n * sizeof(T));}
+
+    Pool *pool_;
+};
+
+template<class T, class U, class Pool>
+bool operator==(const TCPoolAllocator<T, Pool> &a, const TCPoolAllocator<U, Pool> &b) {return a.pool_ == b.pool_;}
+template<class T, class U, class Pool>
+bool operator!=(const TCPoolAllocator<T, Pool> &a, const TCPoolAllocator<U, Pool> &b) {return a.pool_ != b.pool_;}
+
+//! Stateless STL allocator backed by per-thread caches over a process wide pool.
+template<class T, class Upstream = std::allocator<char>>
+struct TCThreadCachedAllocator {
+    typedef T value_type;
+
+    TCThreadCachedAllocator() = default;
+    template<class U> TCThreadCachedAllocator(const TCThreadCachedAllocator<U, Upstream> &) noexcept {}
+
+    ALWAYS_INLINE T *allocate(const size_t n) {
+        tc_alloc::ThreadCache<Upstream> * const cache = tc_alloc::ThreadCache<Upstream>::instance();
+        if (cache == nullptr) return (T *) tc_alloc::CentralPool<Upstream>::instance().allocate(n * sizeof(T));
+        return (T *) cache->allocate(n * sizeof(T));
+    }
+    ALWAYS_INLINE void deallocate(T * const p, const size_t n) {
+        tc_alloc::ThreadCache<Upstream> * const cache = tc_alloc::ThreadCache<Upstream>::instance();
+        if (cache == nullptr) tc_alloc::CentralPool<Upstream>::instance().deallocate(p, n * sizeof(T));
+        else cache->deallocate(p, n * sizeof(T));
+    }
+};
+
+template<class T, class U, class Upstream>
+bool operator==(const TCThreadCachedAllocator<T, Upstream> &, const TCThreadCachedAllocator<U, Upstream> &) {return true;}
+template<class T, class U, class Upstream>
+bool operator!=(const TCThreadCachedAllocator<T, Upstream> &, const TCThreadCachedAllocator<U, Upstream> &) {return false;}
+
+#endif //TC_ALLOCATORS_H
@@ -0,0 +1,257 @@
+#ifndef TC_CONCURRENT_HASH_SET_H
+#define TC_CONCURRENT_HASH_SET_H 1
+
+#include "../defines/tc_defines.h"
+#include "../math/tc_int_math.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+//=================================//
+//=== TC Concurrent Hash Set ======//
+//=================================//
+/*!
+ * Insert-only open addressing (linear probing) hash set of integer keys that many threads can fill at once.
+ * - insert claims an empty slot with a CAS, so there are no locks on the insert path.
+ * - contains never writes and never waits.
+ * - When the load passes 3/4 a table twice the size is allocated and every thread that touches the table helps to
+ *   copy chunks of it across (cooperative, incremental resize). Inserts wait for the copy to finish; lookups don't.
+ * Old tables are only freed by the destructor, because a lookup may still be reading them. That costs at most
+ * about as much memory again as the current table.
+ * EXAMPLE Usage:
+ *   TCConcurrentHashSet<uint32_t> s(1 << 20); //Optional initial capacity.
+ *   //In each thread:
+ *   if (s.insert(key)) { ... first time key was seen ... }
+ *   const bool seen = s.contains(key);
+ */
+
+template<typename T>
+class TCConcurrentHashSet {
+    static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value,
+                  "TCConcurrentHashSet supports uint32_t and uint64_t keys.");
+
+    static constexpr T empty_key_ = T(0); //!< Marks a free slot.
+    static constexpr T moved_key_ = ~T(0); //!< Marks a free slot that was frozen by a resize.
+    static constexpr size_t migrate_chunk_size_ = 4096;
+    static constexpr size_t num_count_shards_ = 64;
+
+    //! One cache line each so that the threads don't all hit the same line.
+    struct alignas(64) CountShard {
+        std::atomic<size_t> count_;
+    };
+
+    struct Table {
+        explicit Table(const size_t capacity) :
+        keys_(new std::atomic<T>[capacity]), capacity_(capacity),
+        num_chunks_((capacity + migrate_chunk_size_ - 1) / migrate_chunk_size_),
+        next_(nullptr), chunks_claimed_(0), chunks_done_(0) {
+            for (size_t i=0; i<capacity; ++i) keys_[i].store(empty_key_, std::memory_order_relaxed);
+            for (size_t i=0; i<num_count_shards_; ++i) shards_[i].count_.store(0, std::memory_order_relaxed);
+        }
+
+        ~Table() {delete [] keys_;}
+
+        //! Plain new only honours the alignment of the shards from C++17 on, so align by hand. The pointer that
+        //! ::operator new returned is stored just before the Table.
+        static void *operator new(const size_t bytes) {
+            char * const raw = (char *) ::operator new(bytes + alignof(Table) + sizeof(void *));
+            char * const p = (char *) ((size_t(raw) + sizeof(void *) + alignof(Table) - 1) & ~(alignof(Table) - 1));
+            ((void **) p)[-1] = raw;
+            return p;
+        }
+
+        static void operator delete(void * const p) noexcept {::operator delete(((void **) p)[-1]);}
+
+        size_t size() const noexcept {
+            size_t n = 0;
+            for (size_t i=0; i<num_count_shards_; ++i) n += shards_[i].count_.load(std::memory_order_relaxed);
+            return n;
+        }
+
+        std::atomic<T> *keys_;
+        const size_t capacity_;//!< Power of two.
+        const size_t num_chunks_;//!< Number of migrate_chunk_size_ chunks copied during a resize.
+
+        CountShard shards_[num_count_shards_];
+
+        std::atomic<Table *> next_;//!< The table being resized into.
+        std::atomic<size_t> chunks_claimed_;
+        std::atomic<size_t> chunks_done_;
+    };
+
+public:
+    explicit TCConcurrentHashSet(const size_t initial_capacity = 1024) :
+    has_empty_key_(false), has_moved_key_(false) {
+        const size_t capacity = std::max(migrate_chunk_size_, size_t(tc_math::next_pow2(uint64_t(initial_capacity))));
+        Table * const table = new Table(capacity);
+        tables_.push_back(table);
+        current_.store(table, std::memory_order_release);
+    }
+
+    ~TCConcurrentHashSet() {
+        for (Table *table : tables_) delete table;
+    }
+
+    TCConcurrentHashSet(const TCConcurrentHashSet &) = delete;
+    TCConcurrentHashSet &operator=(const TCConcurrentHashSet &) = delete;
+
+    //! Returns true if key was inserted and false if it was already in the set. Thread safe.
+    bool insert(const T key) {
+        if (key == empty_key_) return !has_empty_key_.exchange(true);
+        if (key == moved_key_) return !has_moved_key_.exchange(true);
+
+        while (true) {
+            Table * const table = current_.load(std::memory_order_acquire);
+
+            if (table->next_.load(std::memory_order_acquire) != nullptr) {
+                help_resize(table);
+                continue;
+            }
+
+            const int r = insert_into(table, key);
+            if (r == 2) start_resize(table);
+            if (r >= 0) return r != 0;
+            // The slot was frozen or the table is full, so help to finish the resize and retry on the new table.
+            start_resize(table);
+        }
+    }
+
+    //! True if key is in the set. Thread safe and wait free apart from following resized tables.
+    bool contains(const T key) const noexcept {
+        if (key == empty_key_) return has_empty_key_.load(std::memory_order_relaxed);
+        if (key == moved_key_) return has_moved_key_.load(std::memory_order_relaxed);
+
+        const Table *table = current_.load(std::memory_order_acquire);
+        const uint64_t h = hash(key);
+
+        while (true) {
+            const size_t mask = table->capacity_ - 1;
+            bool follow_next = true;
+
+            for (size_t p=0, i=size_t(h)&mask; p<table->capacity_; ++p, i=(i+1)&mask) {
+                const T k = table->keys_[i].load(std::memory_order_acquire);
+                if (k == key) return true;
+                if (k == empty_key_) {follow_next = false; break;}
+                if (k == moved_key_) break; //The chain was cut off by a resize; later inserts went to next_.
+            }
+
+            const Table * const next = table->next_.load(std::memory_order_acquire);
+            if ((!follow_next) || (next == nullptr)) return false;
+            table = next;
+        }
+    }
+
+    ALWAYS_INLINE size_t count(const T key) const noexcept {return contains(key) ? 1 : 0;}
+
+    //! Number of keys. Only exact when no thread is inserting.
+    size_t size() const noexcept {
+        return current_.load(std::memory_order_acquire)->size() +
+               has_empty_key_.load(std::memory_order_relaxed) + has_moved_key_.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const noexcept {return current_.load(std::memory_order_acquire)->capacity_;}
+
+    //! Bytes held by the current and the retired tables.
+    size_t get_memory_usage() const {
+        std::lock_guard<std::mutex> lock(tables_mutex_);
+        size_t bytes = 0;
+        for (const Table *table : tables_) bytes += sizeof(Table) + table->capacity_ * sizeof(std::atomic<T>);
+        return bytes;
+    }
+
+private:
+    //! Multiplicative hash with the high bits mixed down, because only the low bits index the table.
+    static ALWAYS_INLINE uint64_t hash(const T key) noexcept {
+        const uint64_t h = uint64_t(key) * UINT64_C(0x9E3779B97F4A7C15);
+        return h ^ (h >> 29);
+    }
+
+    //! Returns 1 if inserted, 2 if inserted and the table should grow, 0 if already present and -1 if the insert must
+    //! be retried on a resized table.
+    static int insert_into(Table * const table, const T key) noexcept {
+        const size_t mask = table->capacity_ - 1;
+        const uint64_t h = hash(key);
+
+        for (size_t p=0, i=size_t(h)&mask; p<table->capacity_; ++p, i=(i+1)&mask) {
+            T k = table->keys_[i].load(std::memory_order_acquire);
+
+            if (k == empty_key_) {
+                if (table->keys_[i].compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+                    std::atomic<size_t> &shard_count = table->shards_[(h >> 58) & (num_count_shards_ - 1)].count_;
+                    const size_t n = shard_count.fetch_add(1, std::memory_order_relaxed) + 1;
+                    // Each shard gets about 1/num_count_shards_ of the keys; resize when the estimate passes 3/4.
+                    return (n * num_count_shards_ * 4 > table->capacity_ * 3) ? 2 : 1;
+                }
+                //k now holds the key that won the race.
+            }
+
+            if (k == key) return 0;
+            if (k == moved_key_) return -1;
+        }
+
+        return -1; //Full.
+    }
+
+    void start_resize(Table * const table) {
+        if (table->next_.load(std::memory_order_acquire) == nullptr) {
+            Table * const next = new Table(table->capacity_ * 2);
+            Table *expected = nullptr;
+
+            if (table->next_.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+                std::lock_guard<std::mutex> lock(tables_mutex_);
+                tables_.push_back(next);
+            } else {
+                delete next; //Another thread started the resize first.
+            }
+        }
+
+        help_resize(table);
+    }
+
+    //! Copy unclaimed chunks into table->next_ and wait until the other helpers are done.
+    void help_resize(Table * const table) {
+        Table * const next = table->next_.load(std::memory_order_acquire);
+
+        while (true) {
+            const size_t chunk = table->chunks_claimed_.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= table->num_chunks_) break;
+
+            const size_t end = std::min((chunk + 1) * migrate_chunk_size_, table->capacity_);
+
+            for (size_t i=chunk*migrate_chunk_size_; i<end; ++i) {
+                T k = empty_key_;
+                // Freeze empty slots so that no insert can land behind the copy. Keys never change once set.
+                if (!table->keys_[i].compare_exchange_strong(k, moved_key_, std::memory_order_acq_rel)) {
+                    insert_into(next, k); //Can't fail: next_ is twice the size and only the current table is ever resized.
+                }
+            }
+
+            if ((table->chunks_done_.fetch_add(1, std::memory_order_acq_rel) + 1) == table->num_chunks_) {
+                Table *expected = table;
+                current_.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+            }
+        }
+
+        while (current_.load(std::memory_order_acquire) == table) std::this_thread::yield();
+    }
+
+    std::atomic<Table *> current_;
+    std::atomic<bool> has_empty_key_;
+    std::atomic<bool> has_moved_key_;
+
+    std::vector<Table *> tables_;//!< All tables ever allocated. Freed by the destructor.
+    mutable std::mutex tables_mutex_;//!< Only taken when a table is allocated.
+};
+
+template<typename T> constexpr T TCConcurrentHashSet<T>::empty_key_;
+template<typename T> constexpr T TCConcurrentHashSet<T>::moved_key_;
+template<typename T> constexpr size_t TCConcurrentHashSet<T>::migrate_chunk_size_;
+template<typename T> constexpr size_t TCConcurrentHashSet<T>::num_count_shards_;
+
+#endif //TC_CONCURRENT_HASH_SET_H
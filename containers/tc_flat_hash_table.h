@@ -0,0 +1,410 @@
+#ifndef TC_FLAT_HASH_TABLE_H
+#define TC_FLAT_HASH_TABLE_H 1
+
+#include "../defines/tc_defines.h"
+#include "../math/tc_int_math.h"
+
+#include <emmintrin.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+//===========================//
+//=== TC Flat Hash Table ====//
+//===========================//
+/*!
+ * Open addressing hash set/map with SwissTable style SSE2 control byte probing. The keys (and values) are stored
+ * inline in one slot array, so there is no per-element heap allocation and no next pointer. Each slot has one control
+ * byte that is either empty, deleted or the low 7 bits of the hash; 16 control bytes are matched at once.
+ * EXAMPLE Usage:
+ *   TCFlatHashSet<uint32_t> s;
+ *   s.reserve(1000000); //Optional.
+ *   s.insert(42);
+ *   if (s.contains(42)) s.erase(42);
+ *
+ *   TCFlatHashMap<uint32_t, int> m;
+ *   m[42] += 1;
+ *   auto it = m.find(42); //it->first == 42, it->second == 1
+ * Heterogeneous lookup (find/contains/count/erase with a type other than Key) is enabled when both Hash and KeyEqual
+ * define is_transparent. Pointers and iterators are invalidated by a rehash, i.e. by insert and reserve.
+ */
+
+namespace tc_flat_hash {
+    constexpr int8_t ctrl_empty = -128; //0b10000000
+    constexpr int8_t ctrl_deleted = -2; //0b11111110
+    constexpr int group_width = 16;
+
+    //! 16 control bytes matched with SSE2.
+    struct Group {
+        explicit ALWAYS_INLINE Group(const int8_t * const ctrl) noexcept : ctrl_(_mm_loadu_si128((const __m128i *) ctrl)) {}
+
+        //! Bit mask of the bytes equal to h2.
+        ALWAYS_INLINE uint32_t match(const int8_t h2) const noexcept {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_));
+        }
+
+        ALWAYS_INLINE uint32_t match_empty() const noexcept {return match(ctrl_empty);}
+
+        //! Empty and deleted are the only control bytes with the sign bit set.
+        ALWAYS_INLINE uint32_t match_empty_or_deleted() const noexcept {return _mm_movemask_epi8(ctrl_);}
+
+        __m128i ctrl_;
+    };
+
+    //! Mix the hash so that identity hashes (e.g. std::hash<uint32_t>) still spread over H1 and H2.
+    ALWAYS_INLINE uint64_t mix_hash(const size_t hash) noexcept {
+        const uint64_t h = uint64_t(hash) * UINT64_C(0x9E3779B97F4A7C15);
+        return h ^ (h >> 32);
+    }
+
+    template<class Key>
+    struct SetPolicy {
+        typedef Key key_type;
+        typedef Key slot_type;
+        static ALWAYS_INLINE const Key &key(const slot_type &slot) noexcept {return slot;}
+    };
+
+    template<class Key, class Value>
+    struct MapPolicy {
+        typedef Key key_type;
+        typedef std::pair<const Key, Value> slot_type; //The key is const, like in std::unordered_map.
+        static ALWAYS_INLINE const Key &key(const slot_type &slot) noexcept {return slot.first;}
+    };
+
+    //! The table shared by TCFlatHashSet and TCFlatHashMap.
+    template<class Policy, class Hash, class KeyEqual, class Allocator>
+    class FlatHashTable {
+    public:
+        typedef typename Policy::key_type key_type;
+        typedef typename Policy::slot_type value_type;
+        typedef size_t size_type;
+
+    private:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<value_type> SlotAlloc;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<int8_t> CtrlAlloc;
+
+        template<class K, class H, class E>
+        using enable_if_transparent = typename std::enable_if<!std::is_same<K, key_type>::value, decltype(
+            std::declval<typename H::is_transparent *>(), std::declval<typename E::is_transparent *>(), void())>::type;
+
+    public:
+        template<class SlotT>
+        class iterator_base {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename std::remove_const<SlotT>::type value_type;
+            typedef ptrdiff_t difference_type;
+            typedef SlotT *pointer;
+            typedef SlotT &reference;
+
+            iterator_base() noexcept : ctrl_(nullptr), slot_(nullptr), ctrl_end_(nullptr) {}
+            iterator_base(const int8_t *ctrl, SlotT *slot, const int8_t *ctrl_end) noexcept :
+            ctrl_(ctrl), slot_(slot), ctrl_end_(ctrl_end) {skip_non_full();}
+
+            //! Allow iterator -> const_iterator.
+            template<class OtherSlotT, class = typename std::enable_if<std::is_convertible<OtherSlotT *, SlotT *>::value>::type>
+            iterator_base(const iterator_base<OtherSlotT> &other) noexcept : ctrl_(other.ctrl_), slot_(other.slot_), ctrl_end_(other.ctrl_end_) {}
+
+            ALWAYS_INLINE reference operator*() const noexcept {return *slot_;}
+            ALWAYS_INLINE pointer operator->() const noexcept {return slot_;}
+            ALWAYS_INLINE iterator_base &operator++() noexcept {++ctrl_; ++slot_; skip_non_full(); return *this;}
+            ALWAYS_INLINE iterator_base operator++(int) noexcept {iterator_base t = *this; ++(*this); return t;}
+            ALWAYS_INLINE bool operator==(const iterator_base &other) const noexcept {return ctrl_ == other.ctrl_;}
+            ALWAYS_INLINE bool operator!=(const iterator_base &other) const noexcept {return ctrl_ != other.ctrl_;}
+
+        private:
+            template<class> friend class iterator_base;
+
+            ALWAYS_INLINE void skip_non_full() noexcept {
+                while ((ctrl_ < ctrl_end_) && (*ctrl_ < 0)) {++ctrl_; ++slot_;}
+            }
+
+            const int8_t *ctrl_;
+            SlotT *slot_;
+            const int8_t *ctrl_end_;
+        };
+
+        //! Set elements are const; map elements are pair<const Key, Value>, so only the value can be modified.
+        typedef iterator_base<typename std::conditional<std::is_same<key_type, value_type>::value, const value_type, value_type>::type> iterator;
+        typedef iterator_base<const value_type> const_iterator;
+
+        explicit FlatHashTable(const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual(), const Allocator &alloc = Allocator()) :
+        hash_(hash), key_equal_(key_equal), slot_alloc_(alloc), ctrl_alloc_(alloc),
+        ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0), growth_left_(0) {}
+
+        FlatHashTable(const FlatHashTable &other) :
+        hash_(other.hash_), key_equal_(other.key_equal_), slot_alloc_(other.slot_alloc_), ctrl_alloc_(other.ctrl_alloc_),
+        ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0), growth_left_(0) {
+            reserve(other.size_);
+            for (const value_type &slot : other) {
+                const size_t i = prepare_insert(mix_hash(hash_(Policy::key(slot))));
+                new (slots_ + i) value_type(slot);
+            }
+        }
+
+        FlatHashTable(FlatHashTable &&other) noexcept :
+        hash_(std::move(other.hash_)), key_equal_(std::move(other.key_equal_)),
+        slot_alloc_(std::move(other.slot_alloc_)), ctrl_alloc_(std::move(other.ctrl_alloc_)),
+        ctrl_(other.ctrl_), slots_(other.slots_), capacity_(other.capacity_), size_(other.size_), growth_left_(other.growth_left_) {
+            other.ctrl_ = nullptr;
+            other.slots_ = nullptr;
+            other.capacity_ = other.size_ = other.growth_left_ = 0;
+        }
+
+        FlatHashTable &operator=(FlatHashTable other) noexcept {swap(other); return *this;}
+
+        ~FlatHashTable() {destroy_and_deallocate();}
+
+        void swap(FlatHashTable &other) noexcept {
+            std::swap(hash_, other.hash_);
+            std::swap(key_equal_, other.key_equal_);
+            std::swap(slot_alloc_, other.slot_alloc_);
+            std::swap(ctrl_alloc_, other.ctrl_alloc_);
+            std::swap(ctrl_, other.ctrl_);
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(size_, other.size_);
+            std::swap(growth_left_, other.growth_left_);
+        }
+
+        ALWAYS_INLINE iterator begin() noexcept {return iterator(ctrl_, slots_, ctrl_ + capacity_);}
+        ALWAYS_INLINE iterator end() noexcept {return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);}
+        ALWAYS_INLINE const_iterator begin() const noexcept {return const_iterator(ctrl_, slots_, ctrl_ + capacity_);}
+        ALWAYS_INLINE const_iterator end() const noexcept {return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);}
+
+        ALWAYS_INLINE size_t size() const noexcept {return size_;}
+        ALWAYS_INLINE bool empty() const noexcept {return size_ == 0;}
+        ALWAYS_INLINE size_t capacity() const noexcept {return capacity_;}
+        ALWAYS_INLINE double load_factor() const noexcept {return (capacity_ > 0) ? double(size_) / capacity_ : 0.0;}
+
+        //! Bytes allocated for the control bytes and slots.
+        ALWAYS_INLINE size_t get_memory_usage() const noexcept {
+            return (capacity_ > 0) ? (capacity_ + group_width - 1) * sizeof(int8_t) + capacity_ * sizeof(value_type) : 0;
+        }
+
+        void clear() noexcept {
+            destroy_and_deallocate();
+            ctrl_ = nullptr;
+            slots_ = nullptr;
+            capacity_ = size_ = growth_left_ = 0;
+        }
+
+        //! Make room for at least n elements without a rehash.
+        void reserve(const size_t n) {
+            const size_t min_capacity = (n * 8 + 6) / 7; //Max load factor is 7/8.
+            const size_t new_capacity = std::max(size_t(group_width), size_t(tc_math::next_pow2(uint64_t(min_capacity))));
+            if (new_capacity > capacity_) rehash(new_capacity);
+        }
+
+        //! Insert a copy of slot. Returns the position and true if inserted or false if the key was already there.
+        std::pair<iterator, bool> insert(const value_type &slot) {
+            const std::pair<size_t, bool> r = find_or_prepare_insert(Policy::key(slot));
+            if (r.second) new (slots_ + r.first) value_type(slot);
+            return std::make_pair(iterator_at(r.first), r.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type &&slot) {
+            const std::pair<size_t, bool> r = find_or_prepare_insert(Policy::key(slot));
+            if (r.second) new (slots_ + r.first) value_type(std::move(slot));
+            return std::make_pair(iterator_at(r.first), r.second);
+        }
+
+        ALWAYS_INLINE iterator find(const key_type &key) noexcept {return iterator_at(find_index(key));}
+        ALWAYS_INLINE const_iterator find(const key_type &key) const noexcept {return const_iterator_at(find_index(key));}
+        ALWAYS_INLINE bool contains(const key_type &key) const noexcept {return find_index(key) != capacity_;}
+        ALWAYS_INLINE size_t count(const key_type &key) const noexcept {return contains(key) ? 1 : 0;}
+        size_t erase(const key_type &key) noexcept {return erase_index(find_index(key));}
+
+        template<class K, class H = Hash, class E = KeyEqual, class = enable_if_transparent<K, H, E>>
+        ALWAYS_INLINE iterator find(const K &key) noexcept {return iterator_at(find_index(key));}
+        template<class K, class H = Hash, class E = KeyEqual, class = enable_if_transparent<K, H, E>>
+        ALWAYS_INLINE const_iterator find(const K &key) const noexcept {return const_iterator_at(find_index(key));}
+        template<class K, class H = Hash, class E = KeyEqual, class = enable_if_transparent<K, H, E>>
+        ALWAYS_INLINE bool contains(const K &key) const noexcept {return find_index(key) != capacity_;}
+        template<class K, class H = Hash, class E = KeyEqual, class = enable_if_transparent<K, H, E>>
+        ALWAYS_INLINE size_t count(const K &key) const noexcept {return contains(key) ? 1 : 0;}
+        template<class K, class H = Hash, class E = KeyEqual, class = enable_if_transparent<K, H, E>>
+        size_t erase(const K &key) noexcept {return erase_index(find_index(key));}
+
+        template<class SlotT>
+        void erase(const iterator_base<SlotT> it) noexcept {erase_index(it.operator->() - slots_);}
+
+    protected:
+        ALWAYS_INLINE iterator iterator_at(const size_t i) noexcept {return iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);}
+        ALWAYS_INLINE const_iterator const_iterator_at(const size_t i) const noexcept {return const_iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);}
+        ALWAYS_INLINE value_type &slot_at(const size_t i) noexcept {return slots_[i];}
+
+        //! Index of key or capacity_ if not found.
+        template<class K>
+        ALWAYS_INLINE size_t find_index(const K &key) const noexcept {
+            if (capacity_ == 0) return 0;
+            const uint64_t h = mix_hash(hash_(key));
+            const int8_t h2 = int8_t(h & 0x7F);
+            const size_t mask = capacity_ - 1;
+            size_t pos = size_t(h >> 7) & mask;
+
+            for (size_t step = group_width; ; step += group_width) {
+                const Group g(ctrl_ + pos);
+
+                for (uint32_t m = g.match(h2); m != 0; m &= m - 1) {
+                    const size_t i = (pos + tc_math::ctz_nonzero(m)) & mask;
+                    if (key_equal_(Policy::key(slots_[i]), key)) return i;
+                }
+
+                if (g.match_empty() != 0) return capacity_;
+                pos = (pos + step) & mask; //Triangular probing over groups visits every group once.
+            }
+        }
+
+        //! Either the index of key and false, or the index of a new slot (to be constructed by the caller) and true.
+        template<class K>
+        ALWAYS_INLINE std::pair<size_t, bool> find_or_prepare_insert(const K &key) {
+            const size_t i = find_index(key);
+            if (i != capacity_) return std::make_pair(i, false);
+            return std::make_pair(prepare_insert(mix_hash(hash_(key))), true);
+        }
+
+    private:
+        //! First empty or deleted slot in the probe sequence of h.
+        ALWAYS_INLINE size_t find_first_non_full(const uint64_t h) const noexcept {
+            const size_t mask = capacity_ - 1;
+            size_t pos = size_t(h >> 7) & mask;
+
+            for (size_t step = group_width; ; step += group_width) {
+                const uint32_t m = Group(ctrl_ + pos).match_empty_or_deleted();
+                if (m != 0) return (pos + tc_math::ctz_nonzero(m)) & mask;
+                pos = (pos + step) & mask;
+            }
+        }
+
+        //! Claim a slot for a key with hash h that is known not to be in the table.
+        size_t prepare_insert(const uint64_t h) {
+            if (capacity_ == 0) rehash(group_width);
+            size_t i = find_first_non_full(h);
+
+            if ((growth_left_ == 0) && (ctrl_[i] != ctrl_deleted)) {
+                // Rehash in place if mostly tombstones, otherwise double.
+                rehash(((size_ + 1) * 16 <= capacity_ * 7) ? capacity_ : (capacity_ * 2));
+                i = find_first_non_full(h);
+            }
+
+            growth_left_ -= (ctrl_[i] == ctrl_empty);
+            set_ctrl(i, int8_t(h & 0x7F));
+            ++size_;
+            return i;
+        }
+
+        //! Set a control byte and its clone. The first group_width-1 bytes are cloned past the end for unaligned loads.
+        ALWAYS_INLINE void set_ctrl(const size_t i, const int8_t c) noexcept {
+            ctrl_[i] = c;
+            ctrl_[((i - (group_width - 1)) & (capacity_ - 1)) + (group_width - 1)] = c;
+        }
+
+        size_t erase_index(const size_t i) noexcept {
+            if (i >= capacity_) return 0;
+            slots_[i].~value_type();
+            --size_;
+
+            // If there is an empty slot within a group width on both sides then no probe sequence ever found this
+            // group full, and the slot can become empty instead of a tombstone.
+            const size_t mask = capacity_ - 1;
+            const uint32_t empty_after = Group(ctrl_ + i).match_empty();
+            const uint32_t empty_before = Group(ctrl_ + ((i - group_width) & mask)).match_empty();
+            const bool was_never_full = (empty_after != 0) && (empty_before != 0) &&
+                                        ((tc_math::ctz_nonzero(empty_after) + (tc_math::clz(empty_before) - 16)) < group_width);
+            set_ctrl(i, was_never_full ? ctrl_empty : ctrl_deleted);
+            growth_left_ += was_never_full;
+            return 1;
+        }
+
+        void rehash(const size_t new_capacity) {
+            int8_t * const old_ctrl = ctrl_;
+            value_type * const old_slots = slots_;
+            const size_t old_capacity = capacity_;
+
+            ctrl_ = std::allocator_traits<CtrlAlloc>::allocate(ctrl_alloc_, new_capacity + group_width - 1);
+            slots_ = std::allocator_traits<SlotAlloc>::allocate(slot_alloc_, new_capacity);
+            capacity_ = new_capacity;
+            growth_left_ = new_capacity - new_capacity / 8 - size_;
+            std::memset(ctrl_, ctrl_empty, new_capacity + group_width - 1);
+
+            for (size_t i=0; i<old_capacity; ++i) {
+                if (old_ctrl[i] >= 0) {
+                    const uint64_t h = mix_hash(hash_(Policy::key(old_slots[i])));
+                    const size_t j = find_first_non_full(h);
+                    set_ctrl(j, int8_t(h & 0x7F));
+                    new (slots_ + j) value_type(std::move(old_slots[i]));
+                    old_slots[i].~value_type();
+                }
+            }
+
+            if (old_capacity > 0) {
+                std::allocator_traits<CtrlAlloc>::deallocate(ctrl_alloc_, old_ctrl, old_capacity + group_width - 1);
+                std::allocator_traits<SlotAlloc>::deallocate(slot_alloc_, old_slots, old_capacity);
+            }
+        }
+
+        void destroy_and_deallocate() noexcept {
+            if (capacity_ == 0) return;
+            if (!std::is_trivially_destructible<value_type>::value) {
+                for (size_t i=0; i<capacity_; ++i) if (ctrl_[i] >= 0) slots_[i].~value_type();
+            }
+            std::allocator_traits<CtrlAlloc>::deallocate(ctrl_alloc_, ctrl_, capacity_ + group_width - 1);
+            std::allocator_traits<SlotAlloc>::deallocate(slot_alloc_, slots_, capacity_);
+        }
+
+        static ALWAYS_INLINE uint64_t mix_hash(const size_t hash) noexcept {return tc_flat_hash::mix_hash(hash);}
+
+        Hash hash_;
+        KeyEqual key_equal_;
+        SlotAlloc slot_alloc_;
+        CtrlAlloc ctrl_alloc_;
+
+        int8_t *ctrl_;//!< capacity_ control bytes followed by group_width-1 clones of the first ones.
+        value_type *slots_;
+        size_t capacity_;//!< Zero or a power of two >= group_width.
+        size_t size_;
+        size_t growth_left_;//!< Number of empty slots that can still be filled before the 7/8 max load is reached.
+    };
+}
+
+//! Flat hash set. See the top of this file.
+template<class Key,
+         class Hash = std::hash<Key>,
+         class KeyEqual = std::equal_to<Key>,
+         class Allocator = std::allocator<Key>>
+using TCFlatHashSet = tc_flat_hash::FlatHashTable<tc_flat_hash::SetPolicy<Key>, Hash, KeyEqual, Allocator>;
+
+//! Flat hash map. See the top of this file.
+template<class Key, class Value,
+         class Hash = std::hash<Key>,
+         class KeyEqual = std::equal_to<Key>,
+         class Allocator = std::allocator<std::pair<const Key, Value>>>
+class TCFlatHashMap : public tc_flat_hash::FlatHashTable<tc_flat_hash::MapPolicy<Key, Value>, Hash, KeyEqual, Allocator> {
+    typedef tc_flat_hash::FlatHashTable<tc_flat_hash::MapPolicy<Key, Value>, Hash, KeyEqual, Allocator> Base;
+
+public:
+    using Base::Base;
+    using Base::insert;
+
+    //! Insert a default constructed value if key is not in the map yet.
+    Value &operator[](const Key &key) {
+        const std::pair<size_t, bool> r = this->find_or_prepare_insert(key);
+        if (r.second) new (&this->slot_at(r.first)) typename Base::value_type(key, Value());
+        return this->slot_at(r.first).second;
+    }
+
+    std::pair<typename Base::iterator, bool> insert(const Key &key, const Value &value) {
+        const std::pair<size_t, bool> r = this->find_or_prepare_insert(key);
+        if (r.second) new (&this->slot_at(r.first)) typename Base::value_type(key, value);
+        return std::make_pair(this->iterator_at(r.first), r.second);
+    }
+};
+
+#endif //TC_FLAT_HASH_TABLE_H
@@ -0,0 +1,274 @@
+#ifndef TC_MAPPED_VECTOR_H
+#define TC_MAPPED_VECTOR_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <string>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//=============================//
+//=== TC Mapped Vector ========//
+//=============================//
+/*!
+ * Vector of trivially copyable elements that lives in a memory mapped file, for data sets that should persist
+ * between runs or that are larger than RAM.
+ * - The file is a header page (magic, element size, size) followed by the elements. Reopening a file only maps
+ *   it; nothing is read or parsed until the pages are touched. Files that aren't empty and don't have a matching
+ *   header are left untouched and open() fails.
+ * - Growth doubles the capacity with ftruncate and mremap (munmap/mmap where mremap is not available), so pointers
+ *   and references are invalidated by growth, as for std::vector.
+ * - advise() passes sequential/random/will-need hints to the kernel (madvise). With use_huge_pages the capacity is
+ *   grown in 2MB steps and MADV_HUGEPAGE is requested; the kernel only backs file mappings with huge pages on
+ *   tmpfs/shmem (mounted with huge=) or hugetlbfs.
+ * - close() (or the destructor) truncates the file to the used size. sync() flushes to disk with msync.
+ * - Errors: open/reserve/resize/sync return false; push_back/emplace_back throw std::bad_alloc if the file can't grow.
+ * EXAMPLE Usage:
+ *   TCMappedVector<int> mv;
+ *   if (!mv.open("data.bin")) return;   // Creates the file or maps the existing elements.
+ *   mv.push_back(42);
+ *   mv.advise(TCMappedVector<int>::Access::sequential);
+ *   for (const int x : mv) sum += x;
+ *   mv.close();
+ */
+
+template<class T>
+class TCMappedVector {
+    static_assert(std::is_trivially_copyable<T>::value, "TCMappedVector elements are written to disk as raw bytes.");
+
+    //! The first page of the file. The elements start at the next page so they are page aligned.
+    struct Header {
+        uint64_t magic_;
+        uint64_t element_size_;
+        uint64_t size_;
+    };
+
+    static constexpr uint64_t magic_ = 0x5443564543544F52ull; //!< "TCVECTOR".
+    static constexpr size_t header_bytes_ = 4096;
+    static constexpr size_t huge_page_bytes_ = size_t(1) << 21;
+    static constexpr size_t min_capacity_bytes_ = size_t(1) << 16;
+
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    //! Access pattern hints for advise().
+    enum class Access {normal, sequential, random, will_need};
+
+    TCMappedVector() noexcept {}
+
+    explicit TCMappedVector(const std::string &filename, const bool truncate = false, const bool use_huge_pages = false) {
+        open(filename, truncate, use_huge_pages);
+    }
+
+    ~TCMappedVector() {close();}
+
+    TCMappedVector(const TCMappedVector &) = delete;
+    TCMappedVector &operator=(const TCMappedVector &) = delete;
+
+    TCMappedVector(TCMappedVector &&other) noexcept {swap(other);}
+    TCMappedVector &operator=(TCMappedVector &&other) noexcept {
+        if (this != &other) {close(); swap(other);}
+        return *this;
+    }
+
+    void swap(TCMappedVector &other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(map_, other.map_);
+        std::swap(map_bytes_, other.map_bytes_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(use_huge_pages_, other.use_huge_pages_);
+    }
+
+    /*!
+     * Map the file, creating it if it doesn't exist. truncate discards existing elements. Returns false if the file
+     * can't be opened/mapped or was written with a different element size.
+     */
+    bool open(const std::string &filename, const bool truncate = false, const bool use_huge_pages = false) {
+        close();
+        use_huge_pages_ = use_huge_pages;
+
+        fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+        if (fd_ < 0) return false;
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {close(); return false;}
+
+        if ((st.st_size > 0) && (size_t(st.st_size) < header_bytes_)) {close(); return false;} //Not one of ours.
+
+        const bool is_new = st.st_size == 0;
+        const size_t file_bytes = is_new ? (header_bytes_ + round_up_capacity(0) * sizeof(T)) : size_t(st.st_size);
+        if (is_new && (ftruncate(fd_, off_t(file_bytes)) != 0)) {close(); return false;}
+
+        if (!map_file(file_bytes)) {close(); return false;}
+
+        Header * const header = get_header();
+        if (is_new) {
+            header->magic_ = magic_;
+            header->element_size_ = sizeof(T);
+            header->size_ = 0;
+        } else if ((header->magic_ != magic_) || (header->element_size_ != sizeof(T)) || (header->size_ > capacity_)) {
+            munmap(map_, map_bytes_); //Leave the file as is; close() would truncate it.
+            map_ = nullptr;
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    //! Unmap and truncate the file to the used size. Called by the destructor.
+    void close() noexcept {
+        if (map_ != nullptr) {
+            const size_t used_bytes = header_bytes_ + size() * sizeof(T);
+            munmap(map_, map_bytes_);
+            if (ftruncate(fd_, off_t(used_bytes)) != 0) {} //Only trims the unused capacity.
+            map_ = nullptr;
+        }
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        map_bytes_ = 0;
+        capacity_ = 0;
+    }
+
+    //! Flush the mapped pages to disk.
+    bool sync() noexcept {return (map_ == nullptr) || (msync(map_, map_bytes_, MS_SYNC) == 0);}
+
+    //! Pass an access pattern hint for the elements to the kernel.
+    bool advise(const Access access) noexcept {
+        if (map_ == nullptr) return false;
+        int advice = MADV_NORMAL;
+        switch (access) {
+            case Access::sequential: advice = MADV_SEQUENTIAL; break;
+            case Access::random: advice = MADV_RANDOM; break;
+            case Access::will_need: advice = MADV_WILLNEED; break;
+            default: break;
+        }
+        return madvise(map_, map_bytes_, advice) == 0;
+    }
+
+    ALWAYS_INLINE bool is_open() const noexcept {return map_ != nullptr;}
+    ALWAYS_INLINE size_t size() const noexcept {return (map_ != nullptr) ? size_t(get_header()->size_) : 0;}
+    ALWAYS_INLINE bool empty() const noexcept {return size() == 0;}
+    ALWAYS_INLINE size_t capacity() const noexcept {return capacity_;}
+
+    ALWAYS_INLINE T *data() noexcept {return reinterpret_cast<T *>(static_cast<char *>(map_) + header_bytes_);}
+    ALWAYS_INLINE const T *data() const noexcept {return reinterpret_cast<const T *>(static_cast<const char *>(map_) + header_bytes_);}
+
+    ALWAYS_INLINE T &operator[](const size_t i) noexcept {return data()[i];}
+    ALWAYS_INLINE const T &operator[](const size_t i) const noexcept {return data()[i];}
+    ALWAYS_INLINE T &front() noexcept {return data()[0];}
+    ALWAYS_INLINE const T &front() const noexcept {return data()[0];}
+    ALWAYS_INLINE T &back() noexcept {return data()[size() - 1];}
+    ALWAYS_INLINE const T &back() const noexcept {return data()[size() - 1];}
+
+    ALWAYS_INLINE iterator begin() noexcept {return data();}
+    ALWAYS_INLINE iterator end() noexcept {return data() + size();}
+    ALWAYS_INLINE const_iterator begin() const noexcept {return data();}
+    ALWAYS_INLINE const_iterator end() const noexcept {return data() + size();}
+
+    //! Grow the file to hold at least n elements.
+    bool reserve(const size_t n) noexcept {
+        if (map_ == nullptr) return false;
+        if (n <= capacity_) return true;
+
+        const size_t new_bytes = header_bytes_ + round_up_capacity(n) * sizeof(T);
+        if (ftruncate(fd_, off_t(new_bytes)) != 0) return false;
+        return remap_file(new_bytes);
+    }
+
+    //! New elements are zero (new file pages) or whatever a previous pop_back/resize left behind.
+    bool resize(const size_t n) noexcept {
+        if (!reserve(n)) return false;
+        get_header()->size_ = n;
+        return true;
+    }
+
+    ALWAYS_INLINE void clear() noexcept {if (map_ != nullptr) get_header()->size_ = 0;}
+
+    ALWAYS_INLINE void push_back(const T &value) {
+        const size_t s = size();
+        if (s == capacity_) grow(s + 1);
+        data()[s] = value;
+        get_header()->size_ = s + 1;
+    }
+
+    template<class... Args>
+    ALWAYS_INLINE T &emplace_back(Args &&... args) {
+        const size_t s = size();
+        if (s == capacity_) grow(s + 1);
+        T * const p = new (data() + s) T(std::forward<Args>(args)...);
+        get_header()->size_ = s + 1;
+        return *p;
+    }
+
+    ALWAYS_INLINE void pop_back() noexcept {--get_header()->size_;}
+
+private:
+    ALWAYS_INLINE Header *get_header() noexcept {return static_cast<Header *>(map_);}
+    ALWAYS_INLINE const Header *get_header() const noexcept {return static_cast<const Header *>(map_);}
+
+    //! Capacity for at least n elements: at least double the current capacity, in huge page steps if requested.
+    size_t round_up_capacity(const size_t n) const noexcept {
+        size_t bytes = std::max(std::max(n, capacity_ * 2) * sizeof(T), min_capacity_bytes_);
+        if (use_huge_pages_) bytes = ((bytes + header_bytes_ + huge_page_bytes_ - 1) & ~(huge_page_bytes_ - 1)) - header_bytes_;
+        return bytes / sizeof(T);
+    }
+
+    NEVER_INLINE void grow(const size_t n) {
+        if (!reserve(n)) throw std::bad_alloc();
+    }
+
+    bool map_file(const size_t file_bytes) noexcept {
+        void * const p = mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) return false;
+        set_map(p, file_bytes);
+        return true;
+    }
+
+    bool remap_file(const size_t file_bytes) noexcept {
+#ifdef MREMAP_MAYMOVE
+        void * const p = mremap(map_, map_bytes_, file_bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) return false;
+        set_map(p, file_bytes);
+        return true;
+#else
+        munmap(map_, map_bytes_);
+        map_ = nullptr;
+        return map_file(file_bytes);
+#endif
+    }
+
+    void set_map(void * const p, const size_t file_bytes) noexcept {
+        map_ = p;
+        map_bytes_ = file_bytes;
+        capacity_ = (file_bytes - header_bytes_) / sizeof(T);
+#ifdef MADV_HUGEPAGE
+        if (use_huge_pages_) madvise(map_, map_bytes_, MADV_HUGEPAGE);
+#endif
+    }
+
+    int fd_ = -1;
+    void *map_ = nullptr;           //!< Header page followed by the elements.
+    size_t map_bytes_ = 0;          //!< Mapped (and file) size in bytes.
+    size_t capacity_ = 0;           //!< Elements that fit in the mapping.
+    bool use_huge_pages_ = false;
+};
+
+template<class T> constexpr size_t TCMappedVector<T>::header_bytes_;
+template<class T> constexpr size_t TCMappedVector<T>::huge_page_bytes_;
+template<class T> constexpr size_t TCMappedVector<T>::min_capacity_bytes_;
+
+#endif //TC_MAPPED_VECTOR_H
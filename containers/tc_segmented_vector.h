@@ -0,0 +1,371 @@
+#ifndef TC_SEGMENTED_VECTOR_H
+#define TC_SEGMENTED_VECTOR_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+//================================//
+//=== TC Segmented Vector ========//
+//================================//
+/*!
+ * Sequence of fixed size chunks of 2^ChunkShift elements, like a deque with a fixed chunk size that can be tuned.
+ * - Element i is found with a shift and a mask, no division.
+ * - Growing never copies elements, only the (small) chunk pointer map. References stay valid on push/pop at either
+ *   end; iterators are invalidated by pushes, as for std::deque.
+ * - for_each_span hands each contiguous run to the callback so inner loops see plain pointers, and sort first sorts
+ *   each chunk in place before merging the chunks.
+ * EXAMPLE Usage:
+ *   TCSegmentedVector<int> sv;
+ *   sv.push_back(1);
+ *   sv.push_front(0);
+ *   sv.for_each_span([](int *p, size_t n) {for (size_t i=0; i<n; ++i) p[i] *= 2;});
+ *   sv.sort();
+ */
+
+template<class T, int ChunkShift = 12, class Allocator = std::allocator<T>>
+class TCSegmentedVector {
+    static_assert((ChunkShift > 0) && (ChunkShift < 32), "ChunkShift out of range.");
+
+    typedef std::allocator_traits<Allocator> AllocTraits;
+    typedef typename AllocTraits::template rebind_alloc<T *> MapAlloc;
+
+public:
+    static constexpr size_t chunk_size_ = size_t(1) << ChunkShift;
+    static constexpr size_t chunk_mask_ = chunk_size_ - 1;
+
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T &reference;
+    typedef const T &const_reference;
+
+    //! Random access iterator holding the chunk map and a physical index.
+    template<class ValueT>
+    class iterator_base {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef typename std::remove_const<ValueT>::type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef ValueT *pointer;
+        typedef ValueT &reference;
+
+        iterator_base() noexcept : map_(nullptr), p_(0) {}
+        iterator_base(T * const *map, const size_t p) noexcept : map_(map), p_(p) {}
+
+        //! Allow iterator -> const_iterator.
+        template<class OtherT, class = typename std::enable_if<std::is_convertible<OtherT *, ValueT *>::value>::type>
+        iterator_base(const iterator_base<OtherT> &other) noexcept : map_(other.map_), p_(other.p_) {}
+
+        ALWAYS_INLINE reference operator*() const noexcept {return map_[p_ >> ChunkShift][p_ & chunk_mask_];}
+        ALWAYS_INLINE pointer operator->() const noexcept {return &(**this);}
+        ALWAYS_INLINE reference operator[](const difference_type n) const noexcept {return *(*this + n);}
+
+        ALWAYS_INLINE iterator_base &operator++() noexcept {++p_; return *this;}
+        ALWAYS_INLINE iterator_base &operator--() noexcept {--p_; return *this;}
+        ALWAYS_INLINE iterator_base operator++(int) noexcept {iterator_base t = *this; ++p_; return t;}
+        ALWAYS_INLINE iterator_base operator--(int) noexcept {iterator_base t = *this; --p_; return t;}
+        ALWAYS_INLINE iterator_base &operator+=(const difference_type n) noexcept {p_ += n; return *this;}
+        ALWAYS_INLINE iterator_base &operator-=(const difference_type n) noexcept {p_ -= n; return *this;}
+        ALWAYS_INLINE iterator_base operator+(const difference_type n) const noexcept {return iterator_base(map_, p_ + n);}
+        ALWAYS_INLINE iterator_base operator-(const difference_type n) const noexcept {return iterator_base(map_, p_ - n);}
+        friend ALWAYS_INLINE iterator_base operator+(const difference_type n, const iterator_base &it) noexcept {return it + n;}
+        ALWAYS_INLINE difference_type operator-(const iterator_base &other) const noexcept {return difference_type(p_ - other.p_);}
+
+        ALWAYS_INLINE bool operator==(const iterator_base &other) const noexcept {return p_ == other.p_;}
+        ALWAYS_INLINE bool operator!=(const iterator_base &other) const noexcept {return p_ != other.p_;}
+        ALWAYS_INLINE bool operator<(const iterator_base &other) const noexcept {return p_ < other.p_;}
+        ALWAYS_INLINE bool operator>(const iterator_base &other) const noexcept {return p_ > other.p_;}
+        ALWAYS_INLINE bool operator<=(const iterator_base &other) const noexcept {return p_ <= other.p_;}
+        ALWAYS_INLINE bool operator>=(const iterator_base &other) const noexcept {return p_ >= other.p_;}
+
+    private:
+        template<class> friend class iterator_base;
+
+        T * const *map_;
+        size_t p_;//!< Physical index: begin_ + logical index.
+    };
+
+    typedef iterator_base<T> iterator;
+    typedef iterator_base<const T> const_iterator;
+
+    explicit TCSegmentedVector(const Allocator &alloc = Allocator()) :
+    alloc_(alloc), map_(MapAlloc(alloc)), begin_(0), size_(0) {}
+
+    TCSegmentedVector(const TCSegmentedVector &other) :
+    alloc_(AllocTraits::select_on_container_copy_construction(other.alloc_)), map_(MapAlloc(alloc_)), begin_(0), size_(0) {
+        other.for_each_span([this](const T *p, const size_t n) {for (size_t i=0; i<n; ++i) push_back(p[i]);});
+    }
+
+    TCSegmentedVector(TCSegmentedVector &&other) noexcept :
+    alloc_(std::move(other.alloc_)), map_(std::move(other.map_)), begin_(other.begin_), size_(other.size_) {
+        other.map_.clear();
+        other.begin_ = other.size_ = 0;
+    }
+
+    TCSegmentedVector &operator=(TCSegmentedVector other) noexcept {swap(other); return *this;}
+
+    ~TCSegmentedVector() {clear(); free_chunks(0, map_.size());}
+
+    void swap(TCSegmentedVector &other) noexcept {
+        std::swap(alloc_, other.alloc_);
+        map_.swap(other.map_);
+        std::swap(begin_, other.begin_);
+        std::swap(size_, other.size_);
+    }
+
+    ALWAYS_INLINE size_t size() const noexcept {return size_;}
+    ALWAYS_INLINE bool empty() const noexcept {return size_ == 0;}
+
+    //! Number of chunks in the map, allocated or not.
+    ALWAYS_INLINE size_t get_num_chunk_slots() const noexcept {return map_.size();}
+
+    //! Bytes held by the chunks and the chunk map.
+    size_t get_memory_usage() const noexcept {
+        size_t num_chunks = 0;
+        for (T *chunk : map_) num_chunks += (chunk != nullptr);
+        return num_chunks * chunk_size_ * sizeof(T) + map_.capacity() * sizeof(T *);
+    }
+
+    ALWAYS_INLINE T &operator[](const size_t i) noexcept {return at_physical(begin_ + i);}
+    ALWAYS_INLINE const T &operator[](const size_t i) const noexcept {return at_physical(begin_ + i);}
+    ALWAYS_INLINE T &front() noexcept {return at_physical(begin_);}
+    ALWAYS_INLINE const T &front() const noexcept {return at_physical(begin_);}
+    ALWAYS_INLINE T &back() noexcept {return at_physical(begin_ + size_ - 1);}
+    ALWAYS_INLINE const T &back() const noexcept {return at_physical(begin_ + size_ - 1);}
+
+    ALWAYS_INLINE iterator begin() noexcept {return iterator(map_.data(), begin_);}
+    ALWAYS_INLINE iterator end() noexcept {return iterator(map_.data(), begin_ + size_);}
+    ALWAYS_INLINE const_iterator begin() const noexcept {return const_iterator(map_.data(), begin_);}
+    ALWAYS_INLINE const_iterator end() const noexcept {return const_iterator(map_.data(), begin_ + size_);}
+
+    ALWAYS_INLINE void push_back(const T &value) {emplace_back(value);}
+    ALWAYS_INLINE void push_back(T &&value) {emplace_back(std::move(value));}
+    ALWAYS_INLINE void push_front(const T &value) {emplace_front(value);}
+    ALWAYS_INLINE void push_front(T &&value) {emplace_front(std::move(value));}
+
+    template<class... Args>
+    ALWAYS_INLINE T &emplace_back(Args &&... args) {
+        if ((((begin_ + size_) & chunk_mask_) == 0) || map_.empty()) prepare_chunk_back();
+        T * const element = &at_physical(begin_ + size_);
+        AllocTraits::construct(alloc_, element, std::forward<Args>(args)...);
+        ++size_;
+        return *element;
+    }
+
+    template<class... Args>
+    ALWAYS_INLINE T &emplace_front(Args &&... args) {
+        if (((begin_ & chunk_mask_) == 0)) prepare_chunk_front();
+        T * const element = &at_physical(begin_ - 1);
+        AllocTraits::construct(alloc_, element, std::forward<Args>(args)...);
+        --begin_;
+        ++size_;
+        return *element;
+    }
+
+    //! Chunks emptied by pops are kept for reuse (by push_back too after pop_front); see shrink_to_fit.
+    ALWAYS_INLINE void pop_back() noexcept {
+        --size_;
+        AllocTraits::destroy(alloc_, &at_physical(begin_ + size_));
+    }
+
+    ALWAYS_INLINE void pop_front() noexcept {
+        AllocTraits::destroy(alloc_, &at_physical(begin_));
+        ++begin_;
+        --size_;
+    }
+
+    void clear() noexcept {
+        for_each_span([this](T *p, const size_t n) {for (size_t i=0; i<n; ++i) AllocTraits::destroy(alloc_, p + i);});
+        size_ = 0;
+    }
+
+    //! Free the chunks that hold no elements and trim the chunk map.
+    void shrink_to_fit() {
+        if (size_ == 0) {
+            free_chunks(0, map_.size());
+            map_.clear();
+            map_.shrink_to_fit();
+            begin_ = 0;
+            return;
+        }
+
+        const size_t first_chunk = begin_ >> ChunkShift;
+        const size_t last_chunk = (begin_ + size_ - 1) >> ChunkShift;
+        free_chunks(0, first_chunk);
+        free_chunks(last_chunk + 1, map_.size());
+
+        map_.erase(map_.begin() + (last_chunk + 1), map_.end());
+        map_.erase(map_.begin(), map_.begin() + first_chunk);
+        map_.shrink_to_fit();
+        begin_ -= first_chunk << ChunkShift;
+    }
+
+    //! Call f(T *p, size_t n) for each contiguous run of elements, front to back.
+    template<class F>
+    void for_each_span(F f) {
+        for (size_t p=begin_, end=begin_+size_; p<end; ) {
+            const size_t n = std::min(chunk_size_ - (p & chunk_mask_), end - p);
+            f(&at_physical(p), n);
+            p += n;
+        }
+    }
+
+    template<class F>
+    void for_each_span(F f) const {
+        for (size_t p=begin_, end=begin_+size_; p<end; ) {
+            const size_t n = std::min(chunk_size_ - (p & chunk_mask_), end - p);
+            f((const T *) &at_physical(p), n);
+            p += n;
+        }
+    }
+
+    /*!
+     * Sort each chunk in place (contiguous and cache friendly) and then merge chunk aligned runs bottom up. The merges
+     * walk the chunks with pointers instead of going through iterators; the left run is moved to a buffer of at most
+     * half the elements, so the peak extra memory is n/2 and not n.
+     */
+    template<class Compare>
+    void sort(Compare comp) {
+        for_each_span([&comp](T *p, const size_t n) {std::sort(p, p + n, comp);});
+
+        const size_t first = begin_, last = begin_ + size_;
+        const size_t aligned_first = first & ~chunk_mask_; //Runs are aligned to physical chunk boundaries.
+        std::vector<T> buffer;
+
+        for (size_t width=chunk_size_; (aligned_first + width) < last; width*=2) {
+            for (size_t lo=aligned_first; (lo + width) < last; lo += 2 * width) {
+                merge_runs(std::max(lo, first), lo + width, std::min(lo + 2 * width, last), buffer, comp);
+            }
+        }
+    }
+
+    void sort() {sort(std::less<T>());}
+
+private:
+    ALWAYS_INLINE T &at_physical(const size_t p) noexcept {return map_[p >> ChunkShift][p & chunk_mask_];}
+    ALWAYS_INLINE const T &at_physical(const size_t p) const noexcept {return map_[p >> ChunkShift][p & chunk_mask_];}
+
+    /*!
+     * Make sure the chunk holding physical index begin_+size_ exists. If the map is full at the back and at least half
+     * of it is in front of begin_ (chunks emptied by pop_front), those chunks are rotated to the back and reused instead
+     * of growing the map, so FIFO use keeps a bounded number of chunks. This moves begin_.
+     */
+    NEVER_INLINE void prepare_chunk_back() {
+        size_t c = (begin_ + size_) >> ChunkShift;
+
+        if (c >= map_.size()) {
+            const size_t first_chunk = begin_ >> ChunkShift;
+
+            if ((first_chunk > 0) && ((first_chunk * 2) >= map_.size())) {
+                std::rotate(map_.begin(), map_.begin() + first_chunk, map_.end());
+                begin_ -= first_chunk << ChunkShift;
+                c -= first_chunk;
+            } else {
+                map_.resize(c + 1, nullptr); //The map grows geometrically; the chunks never move.
+            }
+        }
+
+        if (map_[c] == nullptr) map_[c] = AllocTraits::allocate(alloc_, chunk_size_);
+    }
+
+    //! Make sure the chunk holding physical index begin_-1 exists, growing the map at the front if needed.
+    NEVER_INLINE void prepare_chunk_front() {
+        if (begin_ == 0) {
+            // Prepend as many empty slots as the map has, so that repeated push_front is amortised O(1).
+            const size_t num_new = std::max(map_.size(), size_t(1));
+            map_.insert(map_.begin(), num_new, nullptr);
+            begin_ += num_new << ChunkShift;
+        }
+
+        const size_t c = (begin_ - 1) >> ChunkShift;
+        if (map_[c] == nullptr) map_[c] = AllocTraits::allocate(alloc_, chunk_size_);
+    }
+
+    //! Merge the sorted physical ranges [lo, mid) and [mid, hi) in place, with the left one moved out to buffer.
+    template<class Compare>
+    void merge_runs(const size_t lo, const size_t mid, const size_t hi, std::vector<T> &buffer, Compare comp) {
+        if (!comp(at_physical(mid), at_physical(mid - 1))) return; //Already in order, e.g. sorted input.
+
+        buffer.clear();
+        for (size_t p=lo; p<mid; ) {
+            const size_t n = std::min(chunk_size_ - (p & chunk_mask_), mid - p);
+            T * const src = &at_physical(p);
+            buffer.insert(buffer.end(), std::make_move_iterator(src), std::make_move_iterator(src + n));
+            p += n;
+        }
+
+        T *a = buffer.data();
+        T * const a_end = a + buffer.size();
+
+        size_t w = lo; //Physical index after the current write span.
+        T *wp = nullptr, *w_end = nullptr;
+        size_t r = mid; //Physical index of the next element of the right run.
+        T *rp = &at_physical(r);
+        T *r_end = rp + std::min(chunk_size_ - (r & chunk_mask_), hi - r);
+
+        while (a != a_end) {
+            if (wp == w_end) { //Next chunk to write to.
+                wp = &at_physical(w);
+                w_end = wp + std::min(chunk_size_ - (w & chunk_mask_), hi - w);
+                w += w_end - wp;
+            }
+
+            if (rp == r_end) {
+                if (r == hi) { //Right run done; move the rest of the left run into place.
+                    while (true) {
+                        const size_t k = std::min(size_t(w_end - wp), size_t(a_end - a));
+                        wp = std::move(a, a + k, wp);
+                        a += k;
+                        if (a == a_end) break;
+                        wp = &at_physical(w);
+                        w_end = wp + std::min(chunk_size_ - (w & chunk_mask_), hi - w);
+                        w += w_end - wp;
+                    }
+                    break;
+                }
+
+                rp = &at_physical(r); //Next chunk of the right run.
+                r_end = rp + std::min(chunk_size_ - (r & chunk_mask_), hi - r);
+            }
+
+            // Each step takes one element from either run, so k steps can't run past any of the three spans.
+            const size_t k = std::min(std::min(size_t(w_end - wp), size_t(a_end - a)), size_t(r_end - rp));
+            T * const rp_start = rp;
+
+            for (size_t i=0; i<k; ++i) {
+                const bool take_right = comp(*rp, *a); //Branch free select; the outcome is unpredictable on random data.
+                *wp++ = std::move(take_right ? *rp : *a);
+                rp += take_right;
+                a += !take_right;
+            }
+
+            r += rp - rp_start;
+        }
+        //The rest of the right run is already in place.
+    }
+
+    void free_chunks(const size_t first, const size_t last) noexcept {
+        for (size_t c=first; c<last; ++c) {
+            if (map_[c] != nullptr) AllocTraits::deallocate(alloc_, map_[c], chunk_size_);
+            map_[c] = nullptr;
+        }
+    }
+
+    Allocator alloc_;
+    std::vector<T *, MapAlloc> map_;//!< Chunk pointers. Null for chunks not allocated yet.
+    size_t begin_;//!< Physical index of the first element.
+    size_t size_;
+};
+
+template<class T, int ChunkShift, class Allocator> constexpr size_t TCSegmentedVector<T, ChunkShift, Allocator>::chunk_size_;
+template<class T, int ChunkShift, class Allocator> constexpr size_t TCSegmentedVector<T, ChunkShift, Allocator>::chunk_mask_;
+
+#endif //TC_SEGMENTED_VECTOR_H
@@ -0,0 +1,216 @@
+#ifndef TC_SORT_H
+#define TC_SORT_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+//=====================//
+//=== TC Sorting ======//
+//=====================//
+/*!
+ * LSD radix sort for 32/64-bit integer keys (and key-value pairs), and a multithreaded sample sort that splits the
+ * keys into one bucket per thread and radix sorts the buckets in parallel.
+ * - radix_sort does one pass to build all the 8-bit digit histograms and skips the digits that are the same for all
+ *   keys (e.g. the high bytes of small keys). It needs a scratch buffer of n keys.
+ * - parallel_sort samples splitters, scatters the keys into buckets in parallel, sorts each bucket and copies back.
+ *   Buckets in which all keys are equal (few unique keys) are not sorted at all.
+ * EXAMPLE Usage:
+ *   std::vector<int> v = ...;
+ *   tc_sort::radix_sort(v.data(), v.size());
+ *   tc_sort::radix_sort_pairs(keys.data(), values.data(), keys.size()); //Stable; values follow their keys.
+ *   tc_sort::parallel_sort(v.data(), v.size()); //Uses std::thread::hardware_concurrency() threads.
+ */
+
+namespace tc_sort {
+    //! Map a key to an unsigned integer with the same order. Signed keys get their sign bit flipped.
+    template<class T>
+    struct RadixKey {
+        static_assert(std::is_integral<T>::value && ((sizeof(T) == 4) || (sizeof(T) == 8)),
+                      "radix sort supports 32 and 64 bit integer keys.");
+        typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type type;
+        static constexpr type sign_flip_ = std::is_signed<T>::value ? (type(1) << (sizeof(T) * 8 - 1)) : type(0);
+
+        static ALWAYS_INLINE type to_unsigned(const T key) noexcept {return type(key) ^ sign_flip_;}
+    };
+
+    constexpr int radix_bits_ = 8;
+    constexpr size_t radix_size_ = size_t(1) << radix_bits_;
+
+    //! The digit histograms of all passes, built in one read of the keys.
+    template<class T>
+    void build_histograms(const T * const keys, const size_t n, std::vector<size_t> &histograms) {
+        constexpr int num_passes = sizeof(T);
+        histograms.assign(num_passes * radix_size_, 0);
+
+        for (size_t i=0; i<n; ++i) {
+            const typename RadixKey<T>::type u = RadixKey<T>::to_unsigned(keys[i]);
+            for (int pass=0; pass<num_passes; ++pass) {
+                ++histograms[pass * radix_size_ + ((u >> (pass * radix_bits_)) & (radix_size_ - 1))];
+            }
+        }
+    }
+
+    /*!
+     * LSD radix sort of keys, with values (if not null) moved along. scratch_keys/scratch_values must hold n
+     * elements. The result is always in keys/values.
+     */
+    template<class T, class V>
+    void radix_sort_impl(T *keys, V *values, T *scratch_keys, V *scratch_values, const size_t n) {
+        if (n < 2) return;
+        T * const keys_out = keys;
+        V * const values_out = values;
+
+        std::vector<size_t> histograms;
+        build_histograms(keys, n, histograms);
+
+        for (int pass=0; pass<int(sizeof(T)); ++pass) {
+            size_t * const histogram = &histograms[pass * radix_size_];
+            const int shift = pass * radix_bits_;
+
+            // Skip the pass if every key has the same digit.
+            if (histogram[(RadixKey<T>::to_unsigned(keys[0]) >> shift) & (radix_size_ - 1)] == n) continue;
+
+            size_t offset = 0; //Exclusive prefix sum gives the first output index of each digit.
+            for (size_t d=0; d<radix_size_; ++d) {
+                const size_t count = histogram[d];
+                histogram[d] = offset;
+                offset += count;
+            }
+
+            for (size_t i=0; i<n; ++i) {
+                const size_t j = histogram[(RadixKey<T>::to_unsigned(keys[i]) >> shift) & (radix_size_ - 1)]++;
+                scratch_keys[j] = keys[i];
+                if (values != nullptr) scratch_values[j] = std::move(values[i]);
+            }
+
+            std::swap(keys, scratch_keys);
+            std::swap(values, scratch_values);
+        }
+
+        if (keys != keys_out) { //An odd number of passes was done.
+            std::memcpy(keys_out, keys, n * sizeof(T));
+            if (values != nullptr) std::move(values, values + n, values_out);
+        }
+    }
+
+    //! Sort 32/64-bit integer keys. Allocates a scratch buffer of n keys.
+    template<class T>
+    void radix_sort(T * const keys, const size_t n) {
+        std::vector<T> scratch(n);
+        radix_sort_impl<T, char>(keys, nullptr, scratch.data(), nullptr, n);
+    }
+
+    //! Sort 32/64-bit integer keys, using the given scratch buffer of n keys.
+    template<class T>
+    void radix_sort(T * const keys, T * const scratch, const size_t n) {
+        radix_sort_impl<T, char>(keys, nullptr, scratch, nullptr, n);
+    }
+
+    //! Stable sort of key-value pairs by key. Allocates scratch buffers of n keys and n values.
+    template<class T, class V>
+    void radix_sort_pairs(T * const keys, V * const values, const size_t n) {
+        std::vector<T> scratch_keys(n);
+        std::vector<V> scratch_values(n);
+        radix_sort_impl(keys, values, scratch_keys.data(), scratch_values.data(), n);
+    }
+
+    //! Run f(thread_index) on num_threads threads (the calling thread is one of them).
+    template<class F>
+    void run_threads(const int num_threads, F f) {
+        std::vector<std::thread> threads;
+        for (int t=1; t<num_threads; ++t) threads.emplace_back(f, t);
+        f(0);
+        for (auto &thread : threads) thread.join();
+    }
+
+    /*!
+     * Multithreaded sample sort of 32/64-bit integer keys. num_threads=0 uses the hardware concurrency. Needs a
+     * scratch buffer of n keys.
+     */
+    template<class T>
+    void parallel_sort(T * const keys, const size_t n, int num_threads = 0) {
+        if (num_threads <= 0) num_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+        if ((num_threads == 1) || (n < (size_t(1) << 16))) {radix_sort(keys, n); return;}
+
+        // == Splitters from a regular sample; duplicates are removed so that few unique keys give fewer buckets.
+        const size_t oversampling = 64;
+        std::vector<T> splitters;
+        {
+            std::vector<T> samples(num_threads * oversampling);
+            for (size_t i=0; i<samples.size(); ++i) samples[i] = keys[(i * 2 + 1) * n / (samples.size() * 2)];
+            std::sort(samples.begin(), samples.end());
+            for (int b=1; b<num_threads; ++b) splitters.push_back(samples[b * oversampling]);
+            splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+        }
+        const size_t num_buckets = splitters.size() + 1;
+
+        // Bucket b holds the keys in [splitters[b-1], splitters[b]).
+        auto bucket_of = [&splitters](const T key) -> size_t {
+            return size_t(std::upper_bound(splitters.begin(), splitters.end(), key) - splitters.begin());
+        };
+
+        // == Count per (block, bucket), then scatter each block into its slice of each bucket.
+        std::vector<T> scratch(n);
+        std::vector<size_t> counts(num_threads * num_buckets, 0); //Row per block.
+
+        run_threads(num_threads, [&](const int t) {
+            const size_t first = t * n / num_threads, last = (t + 1) * n / num_threads;
+            size_t * const block_counts = &counts[t * num_buckets];
+            for (size_t i=first; i<last; ++i) ++block_counts[bucket_of(keys[i])];
+        });
+
+        std::vector<size_t> bucket_begin(num_buckets + 1, 0);
+        std::vector<size_t> offsets(num_threads * num_buckets, 0);
+        {
+            size_t offset = 0;
+            for (size_t b=0; b<num_buckets; ++b) {
+                bucket_begin[b] = offset;
+                for (int t=0; t<num_threads; ++t) {
+                    offsets[t * num_buckets + b] = offset;
+                    offset += counts[t * num_buckets + b];
+                }
+            }
+            bucket_begin[num_buckets] = offset;
+        }
+
+        run_threads(num_threads, [&](const int t) {
+            const size_t first = t * n / num_threads, last = (t + 1) * n / num_threads;
+            size_t * const block_offsets = &offsets[t * num_buckets];
+            for (size_t i=first; i<last; ++i) scratch[block_offsets[bucket_of(keys[i])]++] = keys[i];
+        });
+
+        // == Sort the buckets (largest first, handed out dynamically) and copy them back.
+        std::vector<size_t> bucket_order(num_buckets);
+        for (size_t b=0; b<num_buckets; ++b) bucket_order[b] = b;
+        std::sort(bucket_order.begin(), bucket_order.end(), [&bucket_begin](const size_t a, const size_t b) {
+            return (bucket_begin[a + 1] - bucket_begin[a]) > (bucket_begin[b + 1] - bucket_begin[b]);
+        });
+
+        std::atomic<size_t> next_bucket(0);
+
+        run_threads(num_threads, [&](const int) {
+            for (size_t i=next_bucket.fetch_add(1); i<num_buckets; i=next_bucket.fetch_add(1)) {
+                const size_t b = bucket_order[i];
+                const size_t first = bucket_begin[b], count = bucket_begin[b + 1] - first;
+                T * const bucket = scratch.data() + first;
+
+                if (count == 0) continue;
+
+                const bool all_equal = std::all_of(bucket, bucket + count, [bucket](const T key) {return key == bucket[0];});
+                if (!all_equal) radix_sort(bucket, keys + first, count); //The bucket's final slot is free scratch.
+
+                std::memcpy(keys + first, bucket, count * sizeof(T));
+            }
+        });
+    }
+}
+
+#endif //TC_SORT_H
@@ -0,0 +1,511 @@
+#ifndef TC_TRACKING_ALLOCATOR_H
+#define TC_TRACKING_ALLOCATOR_H 1
+
+#include "../defines/tc_defines.h"
+#include "../math/tc_int_math.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define TC_ALLOC_PROFILE_BACKTRACE 1
+#endif
+
+//===============================//
+//=== TC Allocation Profiler ====//
+//===============================//
+/*!
+ * Drop-in allocation tracking for any container that takes an allocator. Each thread updates its own counters
+ * (no locks, no shared cache lines) and TCAllocProfiler aggregates them on demand. Per allocation site tag it keeps
+ * a histogram of allocations by power of two size class. Every Nth allocation (see set_sample_interval) the call
+ * stack is recorded. Live bytes are exact when aggregated; the peak is tracked to within 64 KB per thread.
+ * EXAMPLE Usage:
+ *   const int site = TCAllocProfiler::register_site("ingest_dedup_set");
+ *   std::unordered_set<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, TrackingAllocator<uint32_t>> s(10, std::hash<uint32_t>(), std::equal_to<uint32_t>(), TrackingAllocator<uint32_t>(site));
+ *   TCAllocProfiler::set_sample_interval(10000); //Optional stack sampling.
+ *   ...
+ *   TCAllocProfiler::record_timeline_sample(TCTimer::get_time()); //Now and then.
+ *   TCAllocProfiler::write_timeline_csv("alloc_timeline.csv");
+ *   TCAllocProfiler::write_histogram_csv("alloc_histogram.csv");
+ *   TCAllocProfiler::write_stack_samples("alloc_stacks.txt");
+ */
+
+namespace tc_alloc_profile {
+    constexpr int max_sites_ = 64; //!< Site 0 is untagged.
+    constexpr int num_size_classes_ = 48; //!< Class c holds sizes in [2^c, 2^(c+1)).
+    constexpr int max_stack_depth_ = 16;
+    constexpr int64_t peak_flush_bytes_ = 64 * 1024; //!< Thread local live byte changes are published in steps of this.
+
+    ALWAYS_INLINE int size_class(const size_t bytes) noexcept {
+        return std::min(std::max(tc_math::ilog2(uint64_t(bytes)), 0), num_size_classes_ - 1);
+    }
+
+    //! Written by one thread only, so relaxed load+store instead of a locked read-modify-write.
+    ALWAYS_INLINE void add_relaxed(std::atomic<uint64_t> &counter, const uint64_t n) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct StackSample {
+        int site_;
+        size_t bytes_;
+        int depth_;
+        void *frames_[max_stack_depth_];
+    };
+
+    //! Counters of one thread.
+    struct ThreadCounters {
+        ThreadCounters() {reset();}
+
+        //! Zero everything, for reuse by a new thread.
+        void reset() {
+            pending_live_delta_ = 0;
+            sample_countdown_ = 0;
+            samples_.clear();
+            for (int s=0; s<max_sites_; ++s) {
+                site_bytes_alloc_[s].store(0, std::memory_order_relaxed);
+                site_bytes_dealloc_[s].store(0, std::memory_order_relaxed);
+                for (int c=0; c<num_size_classes_; ++c) {
+                    site_allocs_[s][c].store(0, std::memory_order_relaxed);
+                    site_deallocs_[s][c].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::atomic<uint64_t> site_allocs_[max_sites_][num_size_classes_];
+        std::atomic<uint64_t> site_deallocs_[max_sites_][num_size_classes_];
+        std::atomic<uint64_t> site_bytes_alloc_[max_sites_];
+        std::atomic<uint64_t> site_bytes_dealloc_[max_sites_];
+
+        int64_t pending_live_delta_;//!< Not yet added to the shared live byte estimate.
+        uint64_t sample_countdown_;//!< Allocations until the next stack sample.
+
+        std::mutex samples_mutex_;//!< Only taken when a sample is taken or read.
+        std::vector<StackSample> samples_;
+    };
+
+    //! Totals per site and size class, summed over all threads.
+    struct Snapshot {
+        Snapshot() : num_allocations_(0), num_deallocations_(0), live_bytes_(0), peak_live_bytes_(0),
+                     site_allocs_(max_sites_, std::vector<uint64_t>(num_size_classes_, 0)),
+                     site_deallocs_(max_sites_, std::vector<uint64_t>(num_size_classes_, 0)),
+                     site_bytes_alloc_(max_sites_, 0), site_bytes_dealloc_(max_sites_, 0) {}
+
+        uint64_t num_allocations_;
+        uint64_t num_deallocations_;
+        int64_t live_bytes_;
+        int64_t peak_live_bytes_;
+
+        std::vector<std::vector<uint64_t>> site_allocs_;
+        std::vector<std::vector<uint64_t>> site_deallocs_;
+        std::vector<uint64_t> site_bytes_alloc_;
+        std::vector<uint64_t> site_bytes_dealloc_;
+    };
+
+    struct TimelineSample {
+        double time_;
+        uint64_t num_allocations_;
+        int64_t live_bytes_;
+        int64_t peak_live_bytes_;
+        uint64_t num_deallocations_;
+    };
+
+    //! Process wide state. The mutex is only taken by thread start/exit, site registration and the readers.
+    struct Registry {
+        //! Never destroyed, so containers freed during static destruction can still report.
+        static Registry &instance() {static Registry * const registry = new Registry; return *registry;}
+
+        Registry() : live_estimate_(0), peak_estimate_(0), sample_interval_(0) {
+            site_names_.push_back("untagged");
+        }
+
+        std::mutex mutex_;
+        std::vector<ThreadCounters *> threads_;//!< Of the running threads.
+        std::vector<ThreadCounters *> free_counters_;//!< Of exited threads, reused by new threads. Never freed.
+        Snapshot retired_;//!< Totals of threads that have exited.
+        std::vector<StackSample> retired_samples_;
+        std::vector<std::string> site_names_;
+        std::vector<TimelineSample> timeline_;
+
+        std::atomic<int64_t> live_estimate_;
+        std::atomic<int64_t> peak_estimate_;
+        std::atomic<uint64_t> sample_interval_;
+    };
+
+    //! Add counters into a snapshot.
+    inline void accumulate(Snapshot &snapshot, const ThreadCounters &counters) {
+        for (int s=0; s<max_sites_; ++s) {
+            snapshot.site_bytes_alloc_[s] += counters.site_bytes_alloc_[s].load(std::memory_order_relaxed);
+            snapshot.site_bytes_dealloc_[s] += counters.site_bytes_dealloc_[s].load(std::memory_order_relaxed);
+            for (int c=0; c<num_size_classes_; ++c) {
+                snapshot.site_allocs_[s][c] += counters.site_allocs_[s][c].load(std::memory_order_relaxed);
+                snapshot.site_deallocs_[s][c] += counters.site_deallocs_[s][c].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! Publish the thread's live byte change to the shared estimate and update the peak.
+    NEVER_INLINE inline void flush_live_delta(ThreadCounters &counters) {
+        Registry &registry = Registry::instance();
+        const int64_t live = registry.live_estimate_.fetch_add(counters.pending_live_delta_, std::memory_order_relaxed) +
+                             counters.pending_live_delta_;
+        counters.pending_live_delta_ = 0;
+
+        int64_t peak = registry.peak_estimate_.load(std::memory_order_relaxed);
+        while ((live > peak) && !registry.peak_estimate_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    NEVER_INLINE inline void record_stack_sample(ThreadCounters &counters, const int site, const size_t bytes) {
+        StackSample sample;
+        sample.site_ = site;
+        sample.bytes_ = bytes;
+#ifdef TC_ALLOC_PROFILE_BACKTRACE
+        sample.depth_ = backtrace(sample.frames_, max_stack_depth_);
+#else
+        sample.depth_ = 0;
+#endif
+        std::lock_guard<std::mutex> lock(counters.samples_mutex_);
+        counters.samples_.push_back(sample);
+    }
+
+    //! Counters are about 50 KB, so those of exited threads are reused rather than kept per thread. They are never
+    //! freed, so a late access through a stale pointer still hits valid memory.
+    NEVER_INLINE inline ThreadCounters *register_thread_counters() {
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+
+        ThreadCounters *counters = nullptr;
+        if (registry.free_counters_.empty()) {
+            counters = new ThreadCounters;
+        } else {
+            counters = registry.free_counters_.back();
+            registry.free_counters_.pop_back();
+        }
+
+        registry.threads_.push_back(counters);
+        return counters;
+    }
+
+    //! Fold the counters of an exiting thread into the retired totals and put them on the free list.
+    NEVER_INLINE inline void retire_thread_counters(ThreadCounters * const counters) {
+        flush_live_delta(*counters);
+
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+        accumulate(registry.retired_, *counters);
+        {
+            std::lock_guard<std::mutex> samples_lock(counters->samples_mutex_);
+            registry.retired_samples_.insert(registry.retired_samples_.end(), counters->samples_.begin(), counters->samples_.end());
+            counters->reset();
+        }
+        registry.threads_.erase(std::find(registry.threads_.begin(), registry.threads_.end(), counters));
+        registry.free_counters_.push_back(counters);
+    }
+
+    //! Trivially destructible, so it can still be read after the thread's thread_locals have been destroyed.
+    struct ThreadState {
+        ThreadCounters *counters_;
+        bool retired_;
+    };
+
+    ALWAYS_INLINE ThreadState &thread_state() {static thread_local ThreadState state = {nullptr, false}; return state;}
+
+    //! Owns the counters of the current thread and retires them when the thread exits.
+    struct ThreadCountersOwner {
+        ThreadCountersOwner() : counters_(register_thread_counters()) {}
+
+        ~ThreadCountersOwner() {
+            retire_thread_counters(counters_);
+            thread_state().counters_ = nullptr;
+            thread_state().retired_ = true;
+        }
+
+        ThreadCounters *counters_;
+    };
+
+    //! The current thread's counters, or nullptr once they have been retired (thread exit, and for the main thread
+    //! before static destruction, when globals still deallocate).
+    ALWAYS_INLINE ThreadCounters *thread_counters() {
+        ThreadState &state = thread_state();
+        if ((state.counters_ == nullptr) && !state.retired_) {
+            static thread_local ThreadCountersOwner owner;
+            state.counters_ = owner.counters_;
+        }
+        return state.counters_;
+    }
+
+    //! Count an allocation or deallocation of a thread whose counters are retired straight into the retired totals.
+    NEVER_INLINE inline void on_retired_thread(const int site, const size_t bytes, const bool is_allocation) {
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+        if (is_allocation) {
+            ++registry.retired_.site_allocs_[site][size_class(bytes)];
+            registry.retired_.site_bytes_alloc_[site] += bytes;
+            registry.live_estimate_.fetch_add(int64_t(bytes), std::memory_order_relaxed);
+        } else {
+            ++registry.retired_.site_deallocs_[site][size_class(bytes)];
+            registry.retired_.site_bytes_dealloc_[site] += bytes;
+            registry.live_estimate_.fetch_sub(int64_t(bytes), std::memory_order_relaxed);
+        }
+    }
+
+    ALWAYS_INLINE void on_allocate(const int site, const size_t bytes) {
+        ThreadCounters * const counters_ptr = thread_counters();
+        if (counters_ptr == nullptr) {
+            on_retired_thread(site, bytes, true);
+            return;
+        }
+
+        ThreadCounters &counters = *counters_ptr;
+        add_relaxed(counters.site_allocs_[site][size_class(bytes)], 1);
+        add_relaxed(counters.site_bytes_alloc_[site], bytes);
+
+        counters.pending_live_delta_ += int64_t(bytes);
+        if (counters.pending_live_delta_ >= peak_flush_bytes_) flush_live_delta(counters);
+
+        if (counters.sample_countdown_ > 0) {
+            if (--counters.sample_countdown_ == 0) {
+                record_stack_sample(counters, site, bytes);
+                counters.sample_countdown_ = Registry::instance().sample_interval_.load(std::memory_order_relaxed);
+            }
+        } else {
+            counters.sample_countdown_ = Registry::instance().sample_interval_.load(std::memory_order_relaxed);
+        }
+    }
+
+    ALWAYS_INLINE void on_deallocate(const int site, const size_t bytes) {
+        ThreadCounters * const counters_ptr = thread_counters();
+        if (counters_ptr == nullptr) {
+            on_retired_thread(site, bytes, false);
+            return;
+        }
+
+        ThreadCounters &counters = *counters_ptr;
+        add_relaxed(counters.site_deallocs_[site][size_class(bytes)], 1);
+        add_relaxed(counters.site_bytes_dealloc_[site], bytes);
+
+        counters.pending_live_delta_ -= int64_t(bytes);
+        if (counters.pending_live_delta_ <= -peak_flush_bytes_) flush_live_delta(counters);
+    }
+}
+
+//! Readers and settings of the allocation profile. All thread safe.
+struct TCAllocProfiler
+{
+    //! Register an allocation site tag. Registering the same name twice returns the same id.
+    static int register_site(const std::string &name)
+    {
+        tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+
+        const auto it = std::find(registry.site_names_.begin(), registry.site_names_.end(), name);
+        if (it != registry.site_names_.end()) return int(it - registry.site_names_.begin());
+        if (int(registry.site_names_.size()) >= tc_alloc_profile::max_sites_) return 0; //Out of tags; count as untagged.
+
+        registry.site_names_.push_back(name);
+        return int(registry.site_names_.size()) - 1;
+    }
+
+    //! Record the call stack every n-th allocation of each thread. 0 (the default) disables sampling.
+    static void set_sample_interval(const uint64_t n)
+    {
+        tc_alloc_profile::Registry::instance().sample_interval_.store(n, std::memory_order_relaxed);
+    }
+
+    //! Sum the counters of all threads. Other threads may be allocating meanwhile, so totals are approximate then.
+    static tc_alloc_profile::Snapshot get_snapshot()
+    {
+        tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+
+        tc_alloc_profile::Snapshot snapshot = registry.retired_;
+        for (const tc_alloc_profile::ThreadCounters *counters : registry.threads_) tc_alloc_profile::accumulate(snapshot, *counters);
+
+        snapshot.num_allocations_ = snapshot.num_deallocations_ = 0;
+        snapshot.live_bytes_ = 0;
+
+        for (int s=0; s<tc_alloc_profile::max_sites_; ++s)
+        {
+            for (int c=0; c<tc_alloc_profile::num_size_classes_; ++c)
+            {
+                snapshot.num_allocations_ += snapshot.site_allocs_[s][c];
+                snapshot.num_deallocations_ += snapshot.site_deallocs_[s][c];
+            }
+            snapshot.live_bytes_ += int64_t(snapshot.site_bytes_alloc_[s]) - int64_t(snapshot.site_bytes_dealloc_[s]);
+        }
+
+        snapshot.peak_live_bytes_ = std::max(registry.peak_estimate_.load(std::memory_order_relaxed), snapshot.live_bytes_);
+        return snapshot;
+    }
+
+    //! Bytes currently allocated through TrackingAllocator, over all threads and sites.
+    static int64_t get_live_bytes() {return get_snapshot().live_bytes_;}
+
+    //! Number of allocate calls so far, over all threads and sites.
+    static uint64_t get_num_allocations() {return get_snapshot().num_allocations_;}
+
+    //! Start a new peak measurement from the current live bytes.
+    static void reset_peak()
+    {
+        const int64_t live = get_live_bytes();
+        tc_alloc_profile::Registry::instance().peak_estimate_.store(live, std::memory_order_relaxed);
+    }
+
+    //! Remember the current totals for write_timeline_csv.
+    static void record_timeline_sample(const double time)
+    {
+        const tc_alloc_profile::Snapshot snapshot = get_snapshot();
+        const tc_alloc_profile::TimelineSample sample = {time, snapshot.num_allocations_, snapshot.live_bytes_,
+                                                         snapshot.peak_live_bytes_, snapshot.num_deallocations_};
+        tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+        registry.timeline_.push_back(sample);
+    }
+
+    //! The timeline in the same layout as main_hash_table's out.csv.
+    static void write_timeline_csv(const std::string &filename)
+    {
+        tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+        std::ofstream fout(filename);
+
+        fout << "num_allocations" << ", ";
+        fout << "TCTimer::get_time()" << ", ";
+        fout << "live_bytes (MB)" << ", ";
+        fout << "peak_live_bytes (MB)" << ", ";
+        fout << "num_deallocations" << "\n";
+
+        for (const tc_alloc_profile::TimelineSample &sample : registry.timeline_)
+        {
+            fout << sample.num_allocations_ << ", ";
+            fout << sample.time_ << ", ";
+            fout << sample.live_bytes_/(1024*1024) << ", ";
+            fout << sample.peak_live_bytes_/(1024*1024) << ", ";
+            fout << sample.num_deallocations_ << "\n";
+        }
+    }
+
+    //! One row per site and size class that was used.
+    static void write_histogram_csv(const std::string &filename)
+    {
+        const tc_alloc_profile::Snapshot snapshot = get_snapshot();
+        const std::vector<std::string> site_names = get_site_names();
+        std::ofstream fout(filename);
+
+        fout << "site" << ", ";
+        fout << "size_class_min_bytes" << ", ";
+        fout << "num_allocations" << ", ";
+        fout << "num_live" << "\n";
+
+        for (size_t s=0; s<site_names.size(); ++s)
+        {
+            for (int c=0; c<tc_alloc_profile::num_size_classes_; ++c)
+            {
+                if (snapshot.site_allocs_[s][c] == 0) continue;
+                fout << site_names[s] << ", ";
+                fout << (uint64_t(1) << c) << ", ";
+                fout << snapshot.site_allocs_[s][c] << ", ";
+                fout << int64_t(snapshot.site_allocs_[s][c] - snapshot.site_deallocs_[s][c]) << "\n";
+            }
+        }
+    }
+
+    //! Sampled stacks grouped by call stack, most frequent first. Symbols are resolved here, not when sampling.
+    static void write_stack_samples(const std::string &filename)
+    {
+        std::vector<tc_alloc_profile::StackSample> samples;
+        std::vector<std::string> site_names;
+        {
+            tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+            std::lock_guard<std::mutex> lock(registry.mutex_);
+            samples = registry.retired_samples_;
+            for (tc_alloc_profile::ThreadCounters *counters : registry.threads_)
+            {
+                std::lock_guard<std::mutex> samples_lock(counters->samples_mutex_);
+                samples.insert(samples.end(), counters->samples_.begin(), counters->samples_.end());
+            }
+            site_names = registry.site_names_;
+        }
+
+        std::map<std::vector<void *>, std::pair<uint64_t, uint64_t>> stacks; // Stack -> (count, bytes).
+        std::map<std::vector<void *>, int> stack_sites;
+        for (const tc_alloc_profile::StackSample &sample : samples)
+        {
+            const std::vector<void *> stack(sample.frames_, sample.frames_ + sample.depth_);
+            stacks[stack].first += 1;
+            stacks[stack].second += sample.bytes_;
+            stack_sites[stack] = sample.site_;
+        }
+
+        std::vector<std::pair<uint64_t, std::vector<void *>>> sorted;
+        for (const auto &stack : stacks) sorted.push_back(std::make_pair(stack.second.first, stack.first));
+        std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint64_t, std::vector<void *>> &a,
+                                                   const std::pair<uint64_t, std::vector<void *>> &b) {return a.first > b.first;});
+
+        std::ofstream fout(filename);
+        fout << samples.size() << " samples\n";
+
+        for (const auto &entry : sorted)
+        {
+            fout << "\n" << entry.first << " samples, " << stacks[entry.second].second << " bytes, site "
+                 << site_names[stack_sites[entry.second]] << "\n";
+#ifdef TC_ALLOC_PROFILE_BACKTRACE
+            char ** const symbols = backtrace_symbols(entry.second.data(), int(entry.second.size()));
+            for (size_t f=0; f<entry.second.size(); ++f) fout << "  " << (symbols ? symbols[f] : "?") << "\n";
+            free(symbols);
+#endif
+        }
+    }
+
+    static std::vector<std::string> get_site_names()
+    {
+        tc_alloc_profile::Registry &registry = tc_alloc_profile::Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+        return registry.site_names_;
+    }
+};
+
+// Minimal custom allocator that reports every allocation to TCAllocProfiler under an allocation site tag.
+template<typename _Ty>
+struct TrackingAllocator
+{
+    typedef _Ty value_type;
+
+    TrackingAllocator() : site_(0) {}
+    explicit TrackingAllocator(const int site) : site_(site) {}
+    template<typename _Uy> TrackingAllocator(const TrackingAllocator<_Uy> &other) : site_(other.site_) {} // Needed when the container rebinds the allocator.
+
+    _Ty* allocate(std::size_t n)
+    {
+        //Code that runs every allocation
+        tc_alloc_profile::on_allocate(site_, sizeof(_Ty) * n);
+        return std::allocator<_Ty>{}.allocate(n);
+    }
+
+    void deallocate(_Ty* mem, std::size_t n)
+    {
+        //Code that runs every deallocation
+        tc_alloc_profile::on_deallocate(site_, sizeof(_Ty) * n);
+        std::allocator<_Ty>{}.deallocate(mem, n);
+    }
+
+    int site_;//!< Tag from TCAllocProfiler::register_site.
+};
+
+// Allocators with different tags may free each other's memory.
+template<typename _Ty, typename _Uy>
+bool operator==(const TrackingAllocator<_Ty> &, const TrackingAllocator<_Uy> &) {return true;}
+
+template<typename _Ty, typename _Uy>
+bool operator!=(const TrackingAllocator<_Ty> &, const TrackingAllocator<_Uy> &) {return false;}
+
+#endif //TC_TRACKING_ALLOCATOR_H
@@ -37,17 +37,138 @@ private:
 };
 
 
+/*!
+ * Immutable compressed sparse row (CSR) graph. Every vertex's neighbours are a slice of one neighbours_ array and
+ * offsets_[v]..offsets_[v+1] give the slice, so there is no allocation per vertex and a traversal reads the
+ * neighbours sequentially. Built in two passes over an undirected edge list: count the degrees into offsets_, then
+ * scatter the edges. Each vertex's neighbours are in edge list order, the same as a Graph built with add_edge.
+ * The offsets are 32-bit, so the graph can hold up to 2^31 edges (2 neighbour entries each). The optional edge weights
+ * are stored per neighbour entry, parallel to neighbours_.
+ */
+class CSRGraph
+{
+public:
+    //! The neighbours of one vertex. Used like the std::vector<int> returned by Graph::get_adjacent_vertices().
+    struct AdjacentVertices
+    {
+        const int *begin_, *end_;
+        
+        ALWAYS_INLINE int size() const {return int(end_ - begin_);}
+        ALWAYS_INLINE int operator[](const int j) const {return begin_[j];}
+        ALWAYS_INLINE const int *begin() const {return begin_;}
+        ALWAYS_INLINE const int *end() const {return end_;}
+    };
+    
+    CSRGraph() : offsets_(1, 0) {}
+    
+    //! Edges (v, w) are undirected. edge_weights is empty or has one weight per edge. num_vertices<0 means max id + 1.
+    CSRGraph(const std::vector<std::pair<int, int>> &edges, const std::vector<float> &edge_weights = std::vector<float>(),
+             int num_vertices = -1)
+    {
+        if (num_vertices < 0)
+        {
+            num_vertices = 0;
+            for (const auto &edge : edges) num_vertices = std::max(num_vertices, std::max(edge.first, edge.second) + 1);
+        }
+        
+        // Pass 1: the degree of each vertex, then the exclusive prefix sum gives each vertex's first entry.
+        offsets_.assign(num_vertices + 1, 0);
+        for (const auto &edge : edges)
+        {
+            offsets_[edge.first + 1] += 1;
+            offsets_[edge.second + 1] += 1;
+        }
+        for (int v=0; v<num_vertices; ++v) offsets_[v+1] += offsets_[v];
+        
+        // Pass 2: scatter both directions of every edge.
+        const bool has_weights = !edge_weights.empty();
+        std::vector<uint32_t> next_entry(offsets_.begin(), offsets_.end() - 1);
+        neighbours_.resize(offsets_[num_vertices]);
+        if (has_weights) weights_.resize(offsets_[num_vertices]);
+        
+        for (size_t e=0; e<edges.size(); ++e)
+        {
+            const int v = edges[e].first;
+            const int w = edges[e].second;
+            const uint32_t v_entry = next_entry[v]++;
+            const uint32_t w_entry = next_entry[w]++;
+            neighbours_[v_entry] = w;
+            neighbours_[w_entry] = v;
+            if (has_weights) {weights_[v_entry] = edge_weights[e]; weights_[w_entry] = edge_weights[e];}
+        }
+        
+        num_edges_ = int(edges.size());
+    }
+    
+    //! Copy of a Graph (without weights); the neighbour order and so the DFS/BFS sequences are the same.
+    explicit CSRGraph(const Graph &graph) : num_edges_(graph.get_num_edges())
+    {
+        const int num_vertices = graph.get_num_vertices();
+        offsets_.assign(num_vertices + 1, 0);
+        for (int v=0; v<num_vertices; ++v) offsets_[v+1] = offsets_[v] + graph.get_degree(v);
+        
+        neighbours_.reserve(offsets_[num_vertices]);
+        for (int v=0; v<num_vertices; ++v)
+        {
+            const std::vector<int> &adj = graph.get_adjacent_vertices(v);
+            neighbours_.insert(neighbours_.end(), adj.begin(), adj.end());
+        }
+    }
+    
+    ALWAYS_INLINE int get_num_vertices() const {return int(offsets_.size()) - 1;}
+    ALWAYS_INLINE int get_num_edges() const {return num_edges_;}
+    ALWAYS_INLINE int get_degree(const int v) const {return int(offsets_[v+1] - offsets_[v]);}
+    ALWAYS_INLINE bool has_weights() const {return !weights_.empty();}
+    
+    ALWAYS_INLINE AdjacentVertices get_adjacent_vertices(const int v) const
+    {
+        return AdjacentVertices{neighbours_.data() + offsets_[v], neighbours_.data() + offsets_[v+1]};
+    }
+    
+    //! The weights of the edges to get_adjacent_vertices(v), in the same order. Only if has_weights().
+    ALWAYS_INLINE const float *get_adjacent_weights(const int v) const {return weights_.data() + offsets_[v];}
+    
+    //! Bytes used by the offsets, neighbours and weights.
+    size_t get_memory_usage() const
+    {
+        return offsets_.size() * sizeof(uint32_t) + neighbours_.size() * sizeof(int) + weights_.size() * sizeof(float);
+    }
+    
+private:
+    int num_edges_ = 0;
+    std::vector<uint32_t> offsets_;  //!< num_vertices+1 entries; v's neighbours are [offsets_[v], offsets_[v+1]).
+    std::vector<int> neighbours_;    //!< Two entries per edge.
+    std::vector<float> weights_;     //!< Empty, or the weight of each neighbours_ entry.
+};
+
+
+//! Works on a Graph or a CSRGraph. The graph is referenced, not copied, so it must outlive the DFS.
+//! The arrays are allocated once; run() searches again from another vertex and only resets the vertices it reached.
+template<class GraphType = Graph>
 class DFS
 {
 public:
-    DFS(const Graph &graph, const int start_vertex) :
-    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(start_vertex)
+    explicit DFS(const GraphType &graph) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(-1)
     {
         vertex_sequence_.reserve(num_vertices_);
         vertex_flags_.resize(num_vertices_, 0);
         edge_to_.resize(num_vertices_, 0);
         depth_to_.resize(num_vertices_, 0);
+    }
+    
+    DFS(const GraphType &graph, const int start_vertex) : DFS(graph)
+    {
+        run(start_vertex);
+    }
+    
+    void run(const int start_vertex)
+    {
+        for (const int v : vertex_sequence_) vertex_flags_[v] = 0;
+        vertex_sequence_.clear();
         
+        start_vertex_ = start_vertex;
+        depth_to_[start_vertex_] = 0;
         dfs(start_vertex_);
     }
     
@@ -89,48 +210,78 @@ public:
     
 private:
     void dfs(const int v)
-    {
+    {//Iterative, with (vertex, next neighbour index) on an explicit stack, so that long paths can't overflow the call stack.
         vertex_sequence_.push_back(v);
         vertex_flags_[v] = 1;
+        stack_.clear();
+        stack_.emplace_back(v, 0);
         
-        const std::vector<int> &adj = graph_.get_adjacent_vertices(v);
-        
-        for (int j=0; j<adj.size(); ++j)
+        while (!stack_.empty())
         {
-            const int w = adj[j];
-            if (vertex_flags_[w] == 0)
-            {
-                edge_to_[w] = v;
-                depth_to_[w] = depth_to_[v] + 1;
-                dfs(w);
+            const int top_v = stack_.back().first;
+            const auto &adj = graph_.get_adjacent_vertices(top_v);
+            int j = stack_.back().second;
+            
+            while ((j<adj.size()) && (vertex_flags_[adj[j]] != 0)) ++j;
+            
+            if (j == adj.size())
+            {//All neighbours visited.
+                stack_.pop_back();
+                continue;
             }
+            
+            stack_.back().second = j + 1;
+            
+            const int w = adj[j];
+            edge_to_[w] = top_v;
+            depth_to_[w] = depth_to_[top_v] + 1;
+            vertex_sequence_.push_back(w);
+            vertex_flags_[w] = 1;
+            stack_.emplace_back(w, 0);
         }
     }
     
 private:
-    const Graph graph_;
+    const GraphType &graph_;
     const int num_vertices_;
-    const int start_vertex_;
+    int start_vertex_;
     
     std::vector<int> vertex_sequence_;
     std::vector<uint8_t> vertex_flags_;
+    std::vector<std::pair<int, int>> stack_; //! Workspace: the path from the start vertex and the next neighbour index of each vertex on it.
     
     std::vector<int> edge_to_; //! For each vertex, which vertex preceded it in the sequence. Undefined for v's not in vertex_sequence_!
     std::vector<int> depth_to_;//! For each vertex, what is the depth to the vertex. Undefined for v's not in vertex_sequence_!
 };
 
 
+//! Works on a Graph or a CSRGraph. The graph is referenced, not copied, so it must outlive the BFS.
+//! The arrays are allocated once; run() searches again from another vertex and only resets the vertices it reached.
+template<class GraphType = Graph>
 class BFS
 {
 public:
-    BFS(const Graph &graph, const int start_vertex) :
-    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(start_vertex)
+    explicit BFS(const GraphType &graph) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(-1)
     {
         vertex_sequence_.reserve(num_vertices_);
         vertex_flags_.resize(num_vertices_, 0);
         edge_to_.resize(num_vertices_, 0);
         depth_to_.resize(num_vertices_, 0);
+    }
+    
+    BFS(const GraphType &graph, const int start_vertex) : BFS(graph)
+    {
+        run(start_vertex);
+    }
+    
+    void run(const int start_vertex)
+    {
+        for (const int v : vertex_sequence_) vertex_flags_[v] = 0;
+        vertex_sequence_.clear();
         
+        start_vertex_ = start_vertex;
+        depth_to_[start_vertex_] = 0;
         bfs(start_vertex_);
     }
     
@@ -172,30 +323,26 @@ public:
     
 private:
     void bfs(const int v)
-    {
-        int queue[num_vertices_];
-        
-        queue[0] = v;
+    {//The vertex sequence is in queue order, so it is the queue: [head, end) is still to be expanded.
+        vertex_sequence_.push_back(v);
         vertex_flags_[v] = 1;
-        int head=0, tail=1;
+        int head=0;
         
-        while (head!=tail)
+        while (head!=vertex_sequence_.size())
         {
-            const int head_v=queue[head];
-            vertex_sequence_.push_back(head_v);
+            const int head_v=vertex_sequence_[head];
             
-            const std::vector<int> &adj = graph_.get_adjacent_vertices(head_v);
+            const auto &adj = graph_.get_adjacent_vertices(head_v);
             
             for (int j=0; j<adj.size(); ++j)
             {
                 const int w = adj[j];
                 if (vertex_flags_[w] == 0)
                 {
-                    queue[tail] = w;
+                    vertex_sequence_.push_back(w);
                     edge_to_[w] = head_v;
                     depth_to_[w] = depth_to_[head_v] + 1;
                     vertex_flags_[w] = 1;
-                    tail+=1;
                 }
             }
             
@@ -204,9 +351,9 @@ private:
     }
     
 private:
-    const Graph graph_;
+    const GraphType &graph_;
     const int num_vertices_;
-    const int start_vertex_;
+    int start_vertex_;
     
     std::vector<int> vertex_sequence_;
     std::vector<uint8_t> vertex_flags_;
@@ -216,35 +363,461 @@ private:
 };
 
 
-//! Find connected components.
+//! Run f(t) on num_threads threads, t=0 on the calling thread.
+template<class F>
+void run_threads(const int num_threads, F f)
+{
+    std::vector<std::thread> threads;
+    for (int t=1; t<num_threads; ++t) threads.emplace_back(f, t);
+    f(0);
+    for (auto &thread : threads) thread.join();
+}
+
+
+//! Direction optimising parallel BFS (Beamer, Asanovic and Patterson, 2012). Works on a Graph or a CSRGraph.
+//! Each level is either top-down (the frontier's threads claim unvisited neighbours with an atomic fetch_or on the
+//! visited bitmap) or bottom-up (every unvisited vertex looks for a neighbour in the frontier bitmap and stops at the
+//! first one). Bottom-up is used while the frontier's edges are more than 1/alpha_ of the unvisited vertices' edges,
+//! and until the frontier is smaller than num_vertices/beta_. edge_to_ and depth_to_ mean the same as in BFS; the
+//! depths are the same, but a vertex's parent can be any neighbour one level up and the order within a level varies.
+//! The graph is referenced, not copied. run() can be called again from other vertices without reallocating.
+template<class GraphType = Graph>
+class ParallelBFS
+{
+public:
+    static constexpr int alpha_ = 14;
+    static constexpr int beta_ = 24;
+    static constexpr int chunk_size_ = 256; //! Frontier vertices, or 64-vertex bitmap words, claimed by a thread at a time.
+    
+    //! num_threads=0 uses the hardware concurrency.
+    explicit ParallelBFS(const GraphType &graph, const int num_threads = 0) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), num_words_((num_vertices_ + 63) / 64),
+    num_threads_((num_threads > 0) ? num_threads : std::max(int(std::thread::hardware_concurrency()), 1)),
+    start_vertex_(-1), num_bottom_up_levels_(0), visited_(num_words_)
+    {
+        vertex_sequence_.reserve(num_vertices_);
+        edge_to_.resize(num_vertices_, 0);
+        depth_to_.resize(num_vertices_, 0);
+        frontier_bits_.resize(num_words_, 0);
+        thread_next_.resize(num_threads_);
+        for (auto &word : visited_) word.store(0, std::memory_order_relaxed);
+        
+        sum_degrees_ = 0;
+        for (int v=0; v<num_vertices_; ++v) sum_degrees_ += graph_.get_degree(v);
+    }
+    
+    void run(const int start_vertex)
+    {
+        for (const int v : vertex_sequence_) visited_[v >> 6].store(0, std::memory_order_relaxed);
+        vertex_sequence_.clear();
+        num_bottom_up_levels_ = 0;
+        
+        start_vertex_ = start_vertex;
+        depth_to_[start_vertex_] = 0;
+        visited_[start_vertex_ >> 6].store(uint64_t(1) << (start_vertex_ & 63), std::memory_order_relaxed);
+        vertex_sequence_.push_back(start_vertex_);
+        
+        int64_t frontier_edges = graph_.get_degree(start_vertex_);
+        int64_t unvisited_edges = sum_degrees_ - frontier_edges;
+        bool bottom_up = false;
+        int level_begin = 0;
+        int depth = 0;
+        
+        while (level_begin != vertex_sequence_.size())
+        {
+            const int level_end = vertex_sequence_.size();
+            const int frontier_size = level_end - level_begin;
+            
+            if (!bottom_up) bottom_up = frontier_edges > (unvisited_edges / alpha_);
+            else bottom_up = frontier_size >= (num_vertices_ / beta_);
+            
+            const int64_t next_frontier_edges = bottom_up ? bottom_up_step(level_begin, level_end, depth) :
+                                                            top_down_step(level_begin, level_end, depth);
+            
+            num_bottom_up_levels_ += bottom_up;
+            unvisited_edges -= next_frontier_edges;
+            frontier_edges = next_frontier_edges;
+            level_begin = level_end;
+            depth += 1;
+        }
+    }
+    
+    const std::vector<int> &get_vertex_sequence()
+    {
+        return vertex_sequence_;
+    }
+    
+    const std::vector<int> &get_edge_to()
+    {
+        return edge_to_;
+    }
+    
+    const std::vector<int> &get_depth_to()
+    {
+        return depth_to_;
+    }
+    
+    bool has_path_to(const int w) const
+    {
+        return (visited_[w >> 6].load(std::memory_order_relaxed) >> (w & 63)) & 1;
+    }
+    
+    std::vector<int> get_path_to(const int w)
+    {
+        std::vector<int> path;
+        int depth = depth_to_[w];
+        int v = w;
+        path.resize(depth+1, 0);
+        
+        for (; depth>=0; --depth)
+        {
+            path[depth] = v;
+            v = edge_to_[v];
+        }
+        
+        return path;
+    }
+    
+    int get_num_threads() const {return num_threads_;}
+    int get_num_bottom_up_levels() const {return num_bottom_up_levels_;}
+    
+private:
+    //! Append each thread's newly visited vertices to vertex_sequence_ (the next frontier).
+    void append_next_frontier(const int num_threads)
+    {
+        for (int t=0; t<num_threads; ++t)
+        {
+            vertex_sequence_.insert(vertex_sequence_.end(), thread_next_[t].begin(), thread_next_[t].end());
+            thread_next_[t].clear();
+        }
+    }
+    
+    //! Expand the frontier vertex_sequence_[level_begin, level_end). Returns the edges of the next frontier.
+    int64_t top_down_step(const int level_begin, const int level_end, const int depth)
+    {
+        const int num_threads = ((level_end - level_begin) > chunk_size_) ? num_threads_ : 1;
+        std::atomic<int> next_chunk(level_begin);
+        std::atomic<int64_t> next_frontier_edges(0);
+        
+        run_threads(num_threads, [&](const int t) {
+            std::vector<int> &next = thread_next_[t];
+            int64_t edges = 0;
+            
+            for (int begin = next_chunk.fetch_add(chunk_size_); begin < level_end; begin = next_chunk.fetch_add(chunk_size_))
+            {
+                const int end = std::min(begin + chunk_size_, level_end);
+                
+                for (int i=begin; i<end; ++i)
+                {
+                    const int v = vertex_sequence_[i];
+                    const auto &adj = graph_.get_adjacent_vertices(v);
+                    
+                    for (int j=0; j<adj.size(); ++j)
+                    {
+                        const int w = adj[j];
+                        const uint64_t bit = uint64_t(1) << (w & 63);
+                        std::atomic<uint64_t> &word = visited_[w >> 6];
+                        
+                        if (((word.load(std::memory_order_relaxed) & bit) == 0) &&
+                            ((word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0))
+                        {//This thread claimed w.
+                            edge_to_[w] = v;
+                            depth_to_[w] = depth + 1;
+                            next.push_back(w);
+                            edges += graph_.get_degree(w);
+                        }
+                    }
+                }
+            }
+            
+            next_frontier_edges.fetch_add(edges, std::memory_order_relaxed);
+        });
+        
+        append_next_frontier(num_threads);
+        return next_frontier_edges.load();
+    }
+    
+    //! Every unvisited vertex looks for a parent in the frontier vertex_sequence_[level_begin, level_end).
+    //! Returns the edges of the next frontier.
+    int64_t bottom_up_step(const int level_begin, const int level_end, const int depth)
+    {
+        std::fill(frontier_bits_.begin(), frontier_bits_.end(), 0);
+        for (int i=level_begin; i<level_end; ++i) frontier_bits_[vertex_sequence_[i] >> 6] |= uint64_t(1) << (vertex_sequence_[i] & 63);
+        
+        std::atomic<int> next_chunk(0);
+        std::atomic<int64_t> next_frontier_edges(0);
+        
+        run_threads(num_threads_, [&](const int t) {
+            std::vector<int> &next = thread_next_[t];
+            int64_t edges = 0;
+            
+            for (int begin = next_chunk.fetch_add(chunk_size_); begin < num_words_; begin = next_chunk.fetch_add(chunk_size_))
+            {
+                const int end = std::min(begin + chunk_size_, num_words_);
+                
+                for (int word_index=begin; word_index<end; ++word_index)
+                {//Only this thread writes the vertices of these words.
+                    uint64_t unvisited = ~visited_[word_index].load(std::memory_order_relaxed);
+                    if (word_index == (num_words_ - 1) && (num_vertices_ & 63)) unvisited &= (uint64_t(1) << (num_vertices_ & 63)) - 1;
+                    uint64_t found = 0;
+                    
+                    while (unvisited != 0)
+                    {
+                        const int bit_index = __builtin_ctzll(unvisited);
+                        unvisited &= unvisited - 1;
+                        const int w = word_index * 64 + bit_index;
+                        const auto &adj = graph_.get_adjacent_vertices(w);
+                        
+                        for (int j=0; j<adj.size(); ++j)
+                        {
+                            const int v = adj[j];
+                            if ((frontier_bits_[v >> 6] >> (v & 63)) & 1)
+                            {
+                                edge_to_[w] = v;
+                                depth_to_[w] = depth + 1;
+                                found |= uint64_t(1) << bit_index;
+                                next.push_back(w);
+                                edges += adj.size();
+                                break;
+                            }
+                        }
+                    }
+                    
+                    if (found != 0) visited_[word_index].fetch_or(found, std::memory_order_relaxed);
+                }
+            }
+            
+            next_frontier_edges.fetch_add(edges, std::memory_order_relaxed);
+        });
+        
+        append_next_frontier(num_threads_);
+        return next_frontier_edges.load();
+    }
+    
+private:
+    const GraphType &graph_;
+    const int num_vertices_;
+    const int num_words_;
+    const int num_threads_;
+    int start_vertex_;
+    int num_bottom_up_levels_;
+    int64_t sum_degrees_;
+    
+    std::vector<int> vertex_sequence_; //! Level by level; also the frontier of each level.
+    std::vector<std::atomic<uint64_t>> visited_;
+    std::vector<uint64_t> frontier_bits_;
+    std::vector<std::vector<int>> thread_next_; //! Each thread's part of the next frontier.
+    
+    std::vector<int> edge_to_; //! For each vertex, which vertex preceded it in the sequence. Undefined for v's not in vertex_sequence_!
+    std::vector<int> depth_to_;//! For each vertex, what is the depth to the vertex. Undefined for v's not in vertex_sequence_!
+};
+
+
+//! Disjoint sets of the ints [0, n) with union by size and path halving, so nearly O(1) per operation.
+class UnionFind
+{
+public:
+    explicit UnionFind(const int n) : num_sets_(n), parent_(n), size_(n, 1)
+    {
+        for (int v=0; v<n; ++v) parent_[v] = v;
+    }
+    
+    ALWAYS_INLINE int find(int v)
+    {
+        while (parent_[v] != v)
+        {
+            parent_[v] = parent_[parent_[v]];
+            v = parent_[v];
+        }
+        return v;
+    }
+    
+    //! Merge the sets of v and w. Returns false if they were already the same set.
+    ALWAYS_INLINE bool unite(const int v, const int w)
+    {
+        int root_v = find(v);
+        int root_w = find(w);
+        if (root_v == root_w) return false;
+        
+        if (size_[root_v] < size_[root_w]) std::swap(root_v, root_w);
+        parent_[root_w] = root_v;
+        size_[root_v] += size_[root_w];
+        num_sets_ -= 1;
+        return true;
+    }
+    
+    ALWAYS_INLINE bool is_connected(const int v, const int w) {return find(v) == find(w);}
+    ALWAYS_INLINE int get_num_sets() const {return num_sets_;}
+    
+private:
+    int num_sets_;
+    std::vector<int> parent_;
+    std::vector<int> size_;
+};
+
+
+//! Lock free concurrent union-find for connected components, as in Afforest (Sutton, Ben-Nun and Barak, 2018):
+//! every vertex points to a vertex with a smaller id and link() hooks the larger root under the smaller one with a
+//! CAS, so concurrent links can't make a cycle. Afforest first links only the first neighbour_rounds_ neighbours of
+//! every vertex, which usually joins most of the graph into one giant component, and then skips the giant component's
+//! vertices when it links the remaining edges (an edge out of it is linked from its other end).
+template<class GraphType = Graph>
+class ConcurrentUnionFind
+{
+public:
+    static constexpr int neighbour_rounds_ = 2;
+    static constexpr int num_samples_ = 1024; //! Vertices sampled to find the giant component.
+    static constexpr int chunk_size_ = 4096;  //! Vertices claimed by a thread at a time.
+    
+    //! num_threads=0 uses the hardware concurrency.
+    ConcurrentUnionFind(const GraphType &graph, const int num_threads = 0) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()),
+    num_threads_((num_threads > 0) ? num_threads : std::max(int(std::thread::hardware_concurrency()), 1)),
+    parent_(num_vertices_)
+    {
+        for_all_vertices([this](const int v) {parent_[v].store(v, std::memory_order_relaxed);});
+        
+        for (int r=0; r<neighbour_rounds_; ++r)
+        {
+            for_all_vertices([this, r](const int v) {
+                const auto &adj = graph_.get_adjacent_vertices(v);
+                if (r < adj.size()) link(v, adj[r]);
+            });
+            compress();
+        }
+        
+        const int giant_root = sample_frequent_root();
+        
+        for_all_vertices([this, giant_root](const int v) {
+            if (parent_[v].load(std::memory_order_relaxed) == giant_root) return; //Compressed, so a direct child.
+            const auto &adj = graph_.get_adjacent_vertices(v);
+            for (int j=neighbour_rounds_; j<adj.size(); ++j) link(v, adj[j]);
+        });
+        compress();
+    }
+    
+    //! The root (smallest vertex id) of v's component.
+    ALWAYS_INLINE int find(const int v) const {return parent_[v].load(std::memory_order_relaxed);}
+    
+private:
+    //! Call f(v) for every vertex on num_threads_ threads.
+    template<class F>
+    void for_all_vertices(F f)
+    {
+        std::atomic<int> next_chunk(0);
+        
+        run_threads((num_vertices_ > chunk_size_) ? num_threads_ : 1, [&](const int /*t*/) {
+            for (int begin = next_chunk.fetch_add(chunk_size_); begin < num_vertices_; begin = next_chunk.fetch_add(chunk_size_))
+            {
+                const int end = std::min(begin + chunk_size_, num_vertices_);
+                for (int v=begin; v<end; ++v) f(v);
+            }
+        });
+    }
+    
+    //! Join the components of u and v.
+    void link(const int u, const int v)
+    {
+        int p1 = parent_[u].load(std::memory_order_relaxed);
+        int p2 = parent_[v].load(std::memory_order_relaxed);
+        
+        while (p1 != p2)
+        {
+            const int high = std::max(p1, p2);
+            const int low = std::min(p1, p2);
+            int p_high = parent_[high].load(std::memory_order_relaxed);
+            
+            if (p_high == low) break; //Already linked.
+            if ((p_high == high) && parent_[high].compare_exchange_strong(p_high, low, std::memory_order_relaxed)) break;
+            
+            p1 = parent_[parent_[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+            p2 = parent_[low].load(std::memory_order_relaxed);
+        }
+    }
+    
+    //! Point every vertex directly at its root.
+    void compress()
+    {
+        for_all_vertices([this](const int v) {
+            int p = parent_[v].load(std::memory_order_relaxed);
+            int pp = parent_[p].load(std::memory_order_relaxed);
+            
+            while (p != pp)
+            {
+                parent_[v].store(pp, std::memory_order_relaxed);
+                p = pp;
+                pp = parent_[p].load(std::memory_order_relaxed);
+            }
+        });
+    }
+    
+    //! The most frequent root among num_samples_ vertices (evenly spaced, so deterministic).
+    int sample_frequent_root() const
+    {
+        if (num_vertices_ == 0) return -1;
+        
+        std::vector<int> roots;
+        roots.reserve(num_samples_);
+        for (int i=0; i<num_samples_; ++i) roots.push_back(find(int(int64_t(i) * num_vertices_ / num_samples_)));
+        std::sort(roots.begin(), roots.end());
+        
+        int best_root = roots[0], best_count = 0;
+        for (int i=0, count=1; i<num_samples_; ++i, ++count)
+        {
+            if ((i + 1 == num_samples_) || (roots[i+1] != roots[i]))
+            {
+                if (count > best_count) {best_count = count; best_root = roots[i];}
+                count = 0;
+            }
+        }
+        return best_root;
+    }
+    
+private:
+    const GraphType &graph_;
+    const int num_vertices_;
+    const int num_threads_;
+    std::vector<std::atomic<int>> parent_;
+};
+
+
+enum class CCMethod {bfs, union_find, concurrent_union_find};
+
+//! Find connected components. Works on a Graph or a CSRGraph. The component ids are numbered in order of each
+//! component's smallest vertex, so all methods give the same vertex_group_ids_.
+//! bfs searches from every vertex not yet in a component, union_find unites the ends of every edge (O(V + E)
+//! without searches) and concurrent_union_find uses ConcurrentUnionFind on num_threads threads (0 for all cores).
+template<class GraphType = Graph>
 class CC
 {
 public:
-    CC(const Graph &graph) :
+    CC(const GraphType &graph, const CCMethod method = CCMethod::union_find, const int num_threads = 0) :
     graph_(graph)
     {
         const int num_vertices = graph.get_num_vertices();
-        
         vertex_group_ids_.resize(num_vertices, -1);
-        int id = 0;
         
-        for (int v=0; v<num_vertices; ++v)
+        if (method == CCMethod::union_find)
         {
-            if (vertex_group_ids_[v] == -1)
-            {//Vertex not part of a connected component yet.
-                //DFS gs(graph, v);
-                BFS gs(graph, v);
-                
-                std::vector<int> component_vertices = gs.get_vertex_sequence();
-                
-                const int component_size = component_vertices.size();
-                for (int i=0; i<component_size; ++i)
+            UnionFind sets(num_vertices);
+            for (int v=0; v<num_vertices; ++v)
+            {
+                const auto &adj = graph_.get_adjacent_vertices(v);
+                for (int j=0; j<adj.size(); ++j)
                 {
-                    vertex_group_ids_[component_vertices[i]] = id;
+                    if (adj[j] > v) sets.unite(v, adj[j]); //Each undirected edge once.
                 }
-                
-                id += 1;
             }
+            number_components([&sets](const int v) {return sets.find(v);});
+        }
+        else if (method == CCMethod::concurrent_union_find)
+        {
+            const ConcurrentUnionFind<GraphType> sets(graph_, num_threads);
+            number_components([&sets](const int v) {return sets.find(v);});
+        }
+        else
+        {
+            bfs_components();
         }
     }
     
@@ -263,14 +836,744 @@ public:
         return vertex_group_ids_;
     }
     
+    int get_num_components() const
+    {
+        return num_components_;
+    }
+    
 private:
-    const Graph graph_;
-    std::vector<int> vertex_group_ids_;
-};
-
-
-// =======================================
-
+    void bfs_components()
+    {
+        const int num_vertices = graph_.get_num_vertices();
+        int id = 0;
+        
+        //DFS<GraphType> gs(graph_);
+        BFS<GraphType> gs(graph_); //One search reused for every component.
+        
+        for (int v=0; v<num_vertices; ++v)
+        {
+            if (vertex_group_ids_[v] == -1)
+            {//Vertex not part of a connected component yet.
+                gs.run(v);
+                
+                const std::vector<int> &component_vertices = gs.get_vertex_sequence();
+                
+                const int component_size = component_vertices.size();
+                for (int i=0; i<component_size; ++i)
+                {
+                    vertex_group_ids_[component_vertices[i]] = id;
+                }
+                
+                id += 1;
+            }
+        }
+        
+        num_components_ = id;
+    }
+    
+    //! Number the components by their smallest vertex, given the root of each vertex's set.
+    template<class FindRoot>
+    void number_components(FindRoot find_root)
+    {
+        const int num_vertices = graph_.get_num_vertices();
+        std::vector<int> root_ids(num_vertices, -1);
+        int id = 0;
+        
+        for (int v=0; v<num_vertices; ++v)
+        {
+            const int root = find_root(v);
+            if (root_ids[root] == -1) root_ids[root] = id++;
+            vertex_group_ids_[v] = root_ids[root];
+        }
+        
+        num_components_ = id;
+    }
+    
+private:
+    const GraphType &graph_;
+    int num_components_ = 0;
+    std::vector<int> vertex_group_ids_;
+};
+
+
+//! Indexed min-heap of vertices keyed by distance, with D children per node. D=4 halves the depth of a binary heap and
+//! a node's children share a cache line, so pop() does fewer cache misses. Each vertex is at most once in the heap;
+//! push_or_decrease() lowers its key if it is already there.
+template<int D = 4>
+class DAryHeap
+{
+public:
+    struct Entry
+    {
+        float key_;
+        int v_;
+    };
+    
+    explicit DAryHeap(const int num_vertices) : pos_(num_vertices, -1) {heap_.reserve(num_vertices);}
+    
+    ALWAYS_INLINE bool empty() const {return heap_.empty();}
+    ALWAYS_INLINE int size() const {return heap_.size();}
+    ALWAYS_INLINE const Entry &top() const {return heap_[0];}
+    
+    ALWAYS_INLINE void push_or_decrease(const int v, const float key)
+    {
+        int i = pos_[v];
+        if (i < 0)
+        {
+            i = heap_.size();
+            heap_.push_back(Entry{key, v});
+        }
+        else
+        {
+            heap_[i].key_ = key;
+        }
+        sift_up(i);
+    }
+    
+    ALWAYS_INLINE Entry pop()
+    {
+        const Entry top_entry = heap_[0];
+        pos_[top_entry.v_] = -1;
+        
+        const Entry last = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty())
+        {
+            heap_[0] = last;
+            sift_down(0);
+        }
+        return top_entry;
+    }
+    
+    void clear()
+    {
+        for (const Entry &entry : heap_) pos_[entry.v_] = -1;
+        heap_.clear();
+    }
+    
+private:
+    ALWAYS_INLINE void sift_up(int i)
+    {
+        const Entry entry = heap_[i];
+        while (i > 0)
+        {
+            const int parent = (i - 1) / D;
+            if (heap_[parent].key_ <= entry.key_) break;
+            heap_[i] = heap_[parent];
+            pos_[heap_[i].v_] = i;
+            i = parent;
+        }
+        heap_[i] = entry;
+        pos_[entry.v_] = i;
+    }
+    
+    ALWAYS_INLINE void sift_down(int i)
+    {
+        const Entry entry = heap_[i];
+        const int size = heap_.size();
+        
+        for (;;)
+        {
+            const int first_child = D * i + 1;
+            if (first_child >= size) break;
+            
+            const int last_child = std::min(first_child + D, size);
+            int best_child = first_child;
+            for (int c=first_child+1; c<last_child; ++c)
+            {
+                if (heap_[c].key_ < heap_[best_child].key_) best_child = c;
+            }
+            
+            if (heap_[best_child].key_ >= entry.key_) break;
+            heap_[i] = heap_[best_child];
+            pos_[heap_[i].v_] = i;
+            i = best_child;
+        }
+        heap_[i] = entry;
+        pos_[entry.v_] = i;
+    }
+    
+    std::vector<Entry> heap_;
+    std::vector<int> pos_; //! Index of each vertex in heap_, -1 if not in the heap.
+};
+
+
+//! Single source shortest paths on a weighted CSRGraph (non-negative weights) with a 4-ary heap. run(source) finds the
+//! distances to all vertices; run(source, target) stops when the target is settled, so only the distances of the
+//! vertices settled by then are final. Re-runs only reset the vertices the previous run reached.
+template<class GraphType = CSRGraph>
+class Dijkstra
+{
+public:
+    explicit Dijkstra(const GraphType &graph) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(-1), heap_(num_vertices_)
+    {
+        dist_to_.resize(num_vertices_, std::numeric_limits<float>::infinity());
+        edge_to_.resize(num_vertices_, 0);
+        reached_.reserve(num_vertices_);
+    }
+    
+    void run(const int start_vertex, const int target_vertex = -1)
+    {
+        for (const int v : reached_) dist_to_[v] = std::numeric_limits<float>::infinity();
+        reached_.clear();
+        heap_.clear();
+        
+        start_vertex_ = start_vertex;
+        dist_to_[start_vertex_] = 0.0f;
+        reached_.push_back(start_vertex_);
+        heap_.push_or_decrease(start_vertex_, 0.0f);
+        
+        while (!heap_.empty())
+        {
+            const int v = heap_.pop().v_;
+            if (v == target_vertex) break;
+            
+            const float dist_v = dist_to_[v];
+            const auto &adj = graph_.get_adjacent_vertices(v);
+            const float * const weights = graph_.get_adjacent_weights(v);
+            
+            for (int j=0; j<adj.size(); ++j)
+            {
+                const int w = adj[j];
+                const float dist_w = dist_v + weights[j];
+                
+                if (dist_w < dist_to_[w])
+                {
+                    if (dist_to_[w] == std::numeric_limits<float>::infinity()) reached_.push_back(w);
+                    dist_to_[w] = dist_w;
+                    edge_to_[w] = v;
+                    heap_.push_or_decrease(w, dist_w);
+                }
+            }
+        }
+    }
+    
+    const std::vector<float> &get_dist_to() const
+    {
+        return dist_to_;
+    }
+    
+    const std::vector<int> &get_edge_to() const
+    {
+        return edge_to_;
+    }
+    
+    bool has_path_to(const int w) const
+    {
+        return dist_to_[w] != std::numeric_limits<float>::infinity();
+    }
+    
+    std::vector<int> get_path_to(const int w) const
+    {
+        std::vector<int> path;
+        for (int v=w; v!=start_vertex_; v=edge_to_[v]) path.push_back(v);
+        path.push_back(start_vertex_);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+    
+private:
+    const GraphType &graph_;
+    const int num_vertices_;
+    int start_vertex_;
+    DAryHeap<4> heap_;
+    
+    std::vector<float> dist_to_; //! Infinity for vertices not reached.
+    std::vector<int> edge_to_;   //! For each vertex, which vertex precedes it on the shortest path. Undefined for v's not reached!
+    std::vector<int> reached_;   //! The vertices with a finite dist_to_, to reset for the next run.
+};
+
+
+//! Point to point shortest path on a weighted undirected CSRGraph: Dijkstra from the source and from the target in
+//! turn (the side with the smaller heap top), until the two heap tops add up to at least the best path seen through
+//! an edge between the two searches. Settles about half the radius of each side, which on road-like networks is a
+//! fraction of the vertices one Dijkstra to the target settles. Re-runs only reset the vertices reached.
+template<class GraphType = CSRGraph>
+class BidirectionalDijkstra
+{
+public:
+    explicit BidirectionalDijkstra(const GraphType &graph) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), start_vertex_(-1), target_vertex_(-1),
+    meet_v_(-1), meet_w_(-1), heaps_{DAryHeap<4>(num_vertices_), DAryHeap<4>(num_vertices_)}
+    {
+        for (int side=0; side<2; ++side)
+        {
+            dist_to_[side].resize(num_vertices_, std::numeric_limits<float>::infinity());
+            edge_to_[side].resize(num_vertices_, 0);
+        }
+    }
+    
+    //! Returns the distance from start_vertex to target_vertex, infinity if there is no path.
+    float run(const int start_vertex, const int target_vertex)
+    {
+        for (int side=0; side<2; ++side)
+        {
+            for (const int v : reached_[side]) dist_to_[side][v] = std::numeric_limits<float>::infinity();
+            reached_[side].clear();
+            heaps_[side].clear();
+        }
+        
+        start_vertex_ = start_vertex;
+        target_vertex_ = target_vertex;
+        const int roots[2] = {start_vertex, target_vertex};
+        for (int side=0; side<2; ++side)
+        {
+            dist_to_[side][roots[side]] = 0.0f;
+            reached_[side].push_back(roots[side]);
+            heaps_[side].push_or_decrease(roots[side], 0.0f);
+        }
+        
+        dist_ = (start_vertex == target_vertex) ? 0.0f : std::numeric_limits<float>::infinity();
+        meet_v_ = meet_w_ = start_vertex;
+        
+        while (!heaps_[0].empty() && !heaps_[1].empty() && ((heaps_[0].top().key_ + heaps_[1].top().key_) < dist_))
+        {
+            const int side = (heaps_[0].top().key_ <= heaps_[1].top().key_) ? 0 : 1;
+            const int v = heaps_[side].pop().v_;
+            
+            const float dist_v = dist_to_[side][v];
+            const auto &adj = graph_.get_adjacent_vertices(v);
+            const float * const weights = graph_.get_adjacent_weights(v);
+            
+            for (int j=0; j<adj.size(); ++j)
+            {
+                const int w = adj[j];
+                const float dist_w = dist_v + weights[j];
+                
+                if (dist_w < dist_to_[side][w])
+                {
+                    if (dist_to_[side][w] == std::numeric_limits<float>::infinity()) reached_[side].push_back(w);
+                    dist_to_[side][w] = dist_w;
+                    edge_to_[side][w] = v;
+                    heaps_[side].push_or_decrease(w, dist_w);
+                }
+                
+                const float dist_through_vw = dist_w + dist_to_[side ^ 1][w];
+                if (dist_through_vw < dist_)
+                {//Best path so far: v, then edge vw, then w to the other side's root.
+                    dist_ = dist_through_vw;
+                    meet_v_ = (side == 0) ? v : w;
+                    meet_w_ = (side == 0) ? w : v;
+                }
+            }
+        }
+        
+        return dist_;
+    }
+    
+    float get_dist() const
+    {
+        return dist_;
+    }
+    
+    //! The shortest path from the start to the target vertex of the last run(). Empty if there is none.
+    std::vector<int> get_path() const
+    {
+        std::vector<int> path;
+        if (dist_ == std::numeric_limits<float>::infinity()) return path;
+        
+        for (int v=meet_v_; v!=start_vertex_; v=edge_to_[0][v]) path.push_back(v);
+        path.push_back(start_vertex_);
+        std::reverse(path.begin(), path.end());
+        
+        if (meet_w_ != meet_v_)
+        {
+            for (int v=meet_w_; v!=target_vertex_; v=edge_to_[1][v]) path.push_back(v);
+            path.push_back(target_vertex_);
+        }
+        return path;
+    }
+    
+private:
+    const GraphType &graph_;
+    const int num_vertices_;
+    int start_vertex_, target_vertex_;
+    float dist_;
+    int meet_v_, meet_w_; //! The edge where the best path goes from the forward to the backward search.
+    
+    DAryHeap<4> heaps_[2];               //! [0] searches from the start vertex, [1] from the target vertex.
+    std::vector<float> dist_to_[2];
+    std::vector<int> edge_to_[2];
+    std::vector<int> reached_[2];
+};
+
+
+//! Parallel single source shortest paths by delta-stepping (Meyer and Sanders, 2003) on a weighted CSRGraph, in the
+//! bucket form of the GAP benchmark: vertices are in buckets of width delta by tentative distance; the threads take
+//! the current bucket's vertices in chunks and relax all their edges with an atomic compare-and-swap min. Improved
+//! vertices go into the thread's own buckets, and the next bucket is the lowest non-empty one of any thread (the
+//! current one again while its vertices keep improving). delta=0 uses the max weight / the average degree.
+//! The distance and the predecessor of a vertex are one 64-bit word (the float bits, which order like the distances
+//! because they are not negative, then the vertex), so a relaxation sets both at once and racing threads can't leave
+//! a predecessor that doesn't match the distance.
+template<class GraphType = CSRGraph>
+class DeltaStepping
+{
+public:
+    static constexpr int chunk_size_ = 64; //! Bucket vertices claimed by a thread at a time.
+    
+    //! num_threads=0 uses the hardware concurrency.
+    DeltaStepping(const GraphType &graph, float delta = 0.0f, const int num_threads = 0) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()),
+    num_threads_((num_threads > 0) ? num_threads : std::max(int(std::thread::hardware_concurrency()), 1)),
+    start_vertex_(-1), dist_and_edge_to_(num_vertices_)
+    {
+        if (delta <= 0.0f)
+        {
+            float max_weight = 0.0f;
+            int64_t num_entries = 0;
+            for (int v=0; v<num_vertices_; ++v)
+            {
+                const float * const weights = graph_.get_adjacent_weights(v);
+                for (int j=0; j<graph_.get_degree(v); ++j) max_weight = std::max(max_weight, weights[j]);
+                num_entries += graph_.get_degree(v);
+            }
+            const float average_degree = std::max(float(num_entries) / std::max(num_vertices_, 1), 1.0f);
+            delta = (max_weight > 0.0f) ? (max_weight / average_degree) : 1.0f;
+        }
+        delta_ = delta;
+        
+        dist_to_.resize(num_vertices_, std::numeric_limits<float>::infinity());
+        edge_to_.resize(num_vertices_, 0);
+        thread_buckets_.resize(num_threads_);
+    }
+    
+    void run(const int start_vertex)
+    {
+        const uint64_t unreached = pack(std::numeric_limits<float>::infinity(), 0);
+        run_threads(num_threads_, [this, unreached](const int t) {
+            for (int v = t; v < num_vertices_; v += num_threads_) dist_and_edge_to_[v].store(unreached, std::memory_order_relaxed);
+        });
+        
+        start_vertex_ = start_vertex;
+        dist_and_edge_to_[start_vertex_].store(pack(0.0f, start_vertex_), std::memory_order_relaxed);
+        frontier_.assign(1, start_vertex_);
+        int bucket = 0;
+        
+        while (!frontier_.empty())
+        {
+            const int frontier_size = frontier_.size();
+            const int num_threads = (frontier_size > chunk_size_) ? num_threads_ : 1;
+            std::atomic<int> next_chunk(0);
+            
+            run_threads(num_threads, [&](const int t) {
+                std::vector<std::vector<int>> &buckets = thread_buckets_[t];
+                
+                for (int begin = next_chunk.fetch_add(chunk_size_); begin < frontier_size; begin = next_chunk.fetch_add(chunk_size_))
+                {
+                    const int end = std::min(begin + chunk_size_, frontier_size);
+                    
+                    for (int i=begin; i<end; ++i)
+                    {
+                        const int v = frontier_[i];
+                        const float dist_v = unpack_dist(dist_and_edge_to_[v].load(std::memory_order_relaxed));
+                        if (dist_v < delta_ * bucket) continue; //Stale: v was improved into an earlier bucket and done.
+                        
+                        const auto &adj = graph_.get_adjacent_vertices(v);
+                        const float * const weights = graph_.get_adjacent_weights(v);
+                        
+                        for (int j=0; j<adj.size(); ++j)
+                        {
+                            const int w = adj[j];
+                            const float dist_w = dist_v + weights[j];
+                            const uint64_t new_w = pack(dist_w, v);
+                            uint64_t old_w = dist_and_edge_to_[w].load(std::memory_order_relaxed);
+                            bool improved = false;
+                            
+                            while (((new_w >> 32) < (old_w >> 32)) &&
+                                   !(improved = dist_and_edge_to_[w].compare_exchange_weak(old_w, new_w, std::memory_order_relaxed))) {}
+                            
+                            if (improved)
+                            {
+                                const size_t w_bucket = std::max(size_t(dist_w / delta_), size_t(bucket));
+                                if (w_bucket >= buckets.size()) buckets.resize(w_bucket + 1);
+                                buckets[w_bucket].push_back(w);
+                            }
+                        }
+                    }
+                }
+            });
+            
+            // The next bucket is the lowest non-empty one of any thread.
+            size_t next_bucket = std::numeric_limits<size_t>::max();
+            for (auto &buckets : thread_buckets_)
+            {
+                for (size_t b=bucket; b<buckets.size(); ++b)
+                {
+                    if (!buckets[b].empty()) {next_bucket = std::min(next_bucket, b); break;}
+                }
+            }
+            
+            frontier_.clear();
+            if (next_bucket == std::numeric_limits<size_t>::max()) break;
+            
+            for (auto &buckets : thread_buckets_)
+            {
+                if (next_bucket < buckets.size())
+                {
+                    frontier_.insert(frontier_.end(), buckets[next_bucket].begin(), buckets[next_bucket].end());
+                    buckets[next_bucket].clear();
+                }
+            }
+            bucket = next_bucket;
+        }
+        
+        run_threads(num_threads_, [this](const int t) {
+            for (int v = t; v < num_vertices_; v += num_threads_)
+            {
+                const uint64_t dist_and_edge_to = dist_and_edge_to_[v].load(std::memory_order_relaxed);
+                dist_to_[v] = unpack_dist(dist_and_edge_to);
+                edge_to_[v] = int(uint32_t(dist_and_edge_to));
+            }
+        });
+    }
+    
+    const std::vector<float> &get_dist_to() const
+    {
+        return dist_to_;
+    }
+    
+    const std::vector<int> &get_edge_to() const
+    {
+        return edge_to_;
+    }
+    
+    bool has_path_to(const int w) const
+    {
+        return dist_to_[w] != std::numeric_limits<float>::infinity();
+    }
+    
+    std::vector<int> get_path_to(const int w) const
+    {
+        std::vector<int> path;
+        for (int v=w; v!=start_vertex_; v=edge_to_[v]) path.push_back(v);
+        path.push_back(start_vertex_);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+    
+    float get_delta() const {return delta_;}
+    
+private:
+    static ALWAYS_INLINE uint64_t pack(const float dist, const int v)
+    {
+        uint32_t dist_bits;
+        memcpy(&dist_bits, &dist, sizeof(dist_bits));
+        return (uint64_t(dist_bits) << 32) | uint32_t(v);
+    }
+    
+    static ALWAYS_INLINE float unpack_dist(const uint64_t dist_and_edge_to)
+    {
+        const uint32_t dist_bits = uint32_t(dist_and_edge_to >> 32);
+        float dist;
+        memcpy(&dist, &dist_bits, sizeof(dist));
+        return dist;
+    }
+    
+    const GraphType &graph_;
+    const int num_vertices_;
+    const int num_threads_;
+    int start_vertex_;
+    float delta_;
+    
+    std::vector<std::atomic<uint64_t>> dist_and_edge_to_; //! Distance bits << 32 | predecessor, while running.
+    std::vector<float> dist_to_;  //! Infinity for vertices not reached.
+    std::vector<int> edge_to_;    //! For each vertex, which vertex precedes it on the shortest path. Undefined for v's not reached!
+    std::vector<int> frontier_;   //! The vertices of the current bucket.
+    std::vector<std::vector<std::vector<int>>> thread_buckets_; //! Each thread's buckets of improved vertices.
+};
+
+
+//! An edge of a minimum spanning forest.
+struct WeightedEdge
+{
+    int v_, w_;
+    float weight_;
+};
+
+
+//! Minimum spanning forest of a weighted undirected CSRGraph by Prim with the 4-ary heap, O(m log n): grows a tree
+//! from the smallest vertex not in a tree yet, each step adds the vertex with the lightest edge to the tree and lowers
+//! the keys of its neighbours with push_or_decrease(). For sparse graphs, unlike the O(n^2) dense Prim of
+//! mst_prim_cached.h.
+template<class GraphType = CSRGraph>
+class PrimMST
+{
+public:
+    explicit PrimMST(const GraphType &graph) :
+    graph_(graph), num_vertices_(graph.get_num_vertices()), total_weight_(0.0), heap_(num_vertices_)
+    {
+        key_.resize(num_vertices_, std::numeric_limits<float>::infinity());
+        edge_to_.resize(num_vertices_, -1);
+        in_tree_.resize(num_vertices_, false);
+        edges_.reserve(std::max(num_vertices_ - 1, 0));
+        
+        for (int root=0; root<num_vertices_; ++root)
+        {
+            if (!in_tree_[root]) grow_tree(root);
+        }
+    }
+    
+    //! The edges in the order Prim added them, n - number of components of them.
+    const std::vector<WeightedEdge> &get_edges() const
+    {
+        return edges_;
+    }
+    
+    double get_total_weight() const
+    {
+        return total_weight_;
+    }
+    
+private:
+    void grow_tree(const int root)
+    {
+        key_[root] = 0.0f;
+        heap_.push_or_decrease(root, 0.0f);
+        
+        while (!heap_.empty())
+        {
+            const int v = heap_.pop().v_;
+            in_tree_[v] = true;
+            if (v != root)
+            {
+                edges_.push_back(WeightedEdge{edge_to_[v], v, key_[v]});
+                total_weight_ += key_[v];
+            }
+            
+            const auto &adj = graph_.get_adjacent_vertices(v);
+            const float * const weights = graph_.get_adjacent_weights(v);
+            
+            for (int j=0; j<adj.size(); ++j)
+            {
+                const int w = adj[j];
+                if (!in_tree_[w] && (weights[j] < key_[w]))
+                {
+                    key_[w] = weights[j];
+                    edge_to_[w] = v;
+                    heap_.push_or_decrease(w, weights[j]);
+                }
+            }
+        }
+    }
+    
+    const GraphType &graph_;
+    const int num_vertices_;
+    double total_weight_;
+    DAryHeap<4> heap_;
+    
+    std::vector<float> key_;     //! Weight of the lightest edge from the tree to each vertex.
+    std::vector<int> edge_to_;   //! The tree end of that edge.
+    std::vector<bool> in_tree_;
+    std::vector<WeightedEdge> edges_;
+};
+
+
+//! Minimum spanning forest of a weighted undirected CSRGraph by Kruskal, O(m log m): the edges are sorted by weight in
+//! parallel (each thread sorts a slice, then the slices are merged pairwise, the merges of a level in parallel) and
+//! taken in order if the UnionFind says they join two trees. Stops once the forest has n - 1 edges. Ties are broken
+//! by the vertices, so the forest is the same for any number of threads.
+template<class GraphType = CSRGraph>
+class KruskalMST
+{
+public:
+    //! num_threads=0 uses the hardware concurrency.
+    explicit KruskalMST(const GraphType &graph, const int num_threads = 0) :
+    num_threads_((num_threads > 0) ? num_threads : std::max(int(std::thread::hardware_concurrency()), 1)),
+    total_weight_(0.0)
+    {
+        const int num_vertices = graph.get_num_vertices();
+        
+        std::vector<WeightedEdge> sorted_edges;
+        sorted_edges.reserve(graph.get_num_edges());
+        for (int v=0; v<num_vertices; ++v)
+        {//Each edge once, from its smaller end.
+            const auto &adj = graph.get_adjacent_vertices(v);
+            const float * const weights = graph.get_adjacent_weights(v);
+            for (int j=0; j<adj.size(); ++j)
+            {
+                if (v < adj[j]) sorted_edges.push_back(WeightedEdge{v, adj[j], weights[j]});
+            }
+        }
+        sort_edges(sorted_edges);
+        
+        UnionFind union_find(num_vertices);
+        edges_.reserve(std::max(num_vertices - 1, 0));
+        
+        for (const WeightedEdge &edge : sorted_edges)
+        {
+            if (union_find.unite(edge.v_, edge.w_))
+            {
+                edges_.push_back(edge);
+                total_weight_ += edge.weight_;
+                if (int(edges_.size()) == (num_vertices - 1)) break;
+            }
+        }
+    }
+    
+    //! The edges by increasing weight, n - number of components of them.
+    const std::vector<WeightedEdge> &get_edges() const
+    {
+        return edges_;
+    }
+    
+    double get_total_weight() const
+    {
+        return total_weight_;
+    }
+    
+private:
+    void sort_edges(std::vector<WeightedEdge> &edges) const
+    {
+        auto is_lighter = [](const WeightedEdge &a, const WeightedEdge &b) {
+            if (a.weight_ != b.weight_) return a.weight_ < b.weight_;
+            return (a.v_ != b.v_) ? (a.v_ < b.v_) : (a.w_ < b.w_);
+        };
+        
+        const int num_edges = edges.size();
+        const int num_slices = std::max(std::min(num_threads_, num_edges / 65536), 1);
+        if (num_slices == 1)
+        {
+            std::sort(edges.begin(), edges.end(), is_lighter);
+            return;
+        }
+        
+        std::vector<int> bounds(num_slices + 1);
+        for (int i=0; i<=num_slices; ++i) bounds[i] = int(int64_t(num_edges) * i / num_slices);
+        
+        run_threads(num_slices, [&edges, &bounds, is_lighter](const int t) {
+            std::sort(edges.begin() + bounds[t], edges.begin() + bounds[t+1], is_lighter);
+        });
+        
+        std::vector<WeightedEdge> buffer(num_edges);
+        std::vector<WeightedEdge> *from = &edges, *to = &buffer;
+        
+        for (int width=1; width<num_slices; width*=2)
+        {//Merge slices [i, i+width) and [i+width, i+2*width) for every i in steps of 2*width.
+            const int num_merges = (num_slices + 2*width - 1) / (2*width);
+            run_threads(num_merges, [&, width](const int t) {
+                const int i = 2 * width * t;
+                const int begin = bounds[i];
+                const int mid = bounds[std::min(i + width, num_slices)];
+                const int end = bounds[std::min(i + 2*width, num_slices)];
+                std::merge(from->begin() + begin, from->begin() + mid, from->begin() + mid, from->begin() + end,
+                           to->begin() + begin, is_lighter);
+            });
+            std::swap(from, to);
+        }
+        
+        if (from != &edges) edges.swap(buffer);
+    }
+    
+    const int num_threads_;
+    double total_weight_;
+    std::vector<WeightedEdge> edges_;
+};
+
+
+// =======================================
+
 
 Graph g;
 //g.add_edge(0, 1);
@@ -288,7 +1591,7 @@ g.add_edge(6, 7);
 g.add_edge(7, 8);
 g.add_edge(8, 9);
 
-DFS dfs(g, 2);
+DFS<> dfs(g, 2);
 
 std::cerr << "\n";
 std::cerr << "dfs.get_vertex_sequence() = " << dfs.get_vertex_sequence() << "\n";
@@ -297,7 +1600,7 @@ std::cerr << "dfs.get_depth_to() = " << dfs.get_depth_to() << "\n";
 std::cerr << dfs.has_path_to(9) << "\n";
 std::cerr << dfs.get_path_to(9) << "\n";
 
-BFS bfs(g, 2);
+BFS<> bfs(g, 2);
 
 std::cerr << "\n";
 std::cerr << "bfs.get_vertex_sequence() = " << bfs.get_vertex_sequence() << "\n";
@@ -306,10 +1609,50 @@ std::cerr << "bfs.get_depth_to() = " << bfs.get_depth_to() << "\n";
 std::cerr << bfs.has_path_to(9) << "\n";
 std::cerr << bfs.get_path_to(9) << "\n";
 
-CC cc(g);
+CC<> cc(g);
 
 std::cerr << "\n";
 std::cerr << "Connected component IDs = " << cc.get_vertex_group_ids_() << "\n";
 
+CSRGraph csr_g(g);
+BFS<CSRGraph> csr_bfs(csr_g, 2);
+CC<CSRGraph> csr_cc(csr_g, CCMethod::concurrent_union_find);
+
+std::cerr << "\n";
+std::cerr << "csr_bfs.get_vertex_sequence() = " << csr_bfs.get_vertex_sequence() << "\n";
+std::cerr << "CSR connected component IDs = " << csr_cc.get_vertex_group_ids_() << "\n";
+
+ParallelBFS<CSRGraph> csr_parallel_bfs(csr_g, 2);
+csr_parallel_bfs.run(2);
+
+std::cerr << "\n";
+std::cerr << "csr_parallel_bfs.get_depth_to() = " << csr_parallel_bfs.get_depth_to() << "\n";
+std::cerr << csr_parallel_bfs.get_path_to(9) << "\n";
+
+std::vector<std::pair<int, int>> weighted_edges = {{0, 1}, {0, 2}, {1, 2}, {1, 3}, {2, 3}, {3, 4}};
+std::vector<float> edge_weights = {4.0f, 1.0f, 2.0f, 5.0f, 8.0f, 3.0f};
+CSRGraph weighted_g(weighted_edges, edge_weights);
+
+Dijkstra<> dijkstra(weighted_g);
+dijkstra.run(0);
+BidirectionalDijkstra<> bidirectional_dijkstra(weighted_g);
+DeltaStepping<> delta_stepping(weighted_g, 2.0f);
+delta_stepping.run(0);
+
+std::cerr << "\n";
+std::cerr << "dijkstra.get_dist_to() = " << dijkstra.get_dist_to() << "\n";
+std::cerr << dijkstra.get_path_to(4) << "\n";
+std::cerr << "bidirectional_dijkstra.run(0, 4) = " << bidirectional_dijkstra.run(0, 4) << "\n";
+std::cerr << bidirectional_dijkstra.get_path() << "\n";
+std::cerr << "delta_stepping.get_dist_to() = " << delta_stepping.get_dist_to() << "\n";
+std::cerr << delta_stepping.get_path_to(4) << "\n";
+
+PrimMST<> prim_mst(weighted_g);
+KruskalMST<> kruskal_mst(weighted_g);
+
+std::cerr << "\n";
+std::cerr << "prim_mst.get_total_weight() = " << prim_mst.get_total_weight() << "\n";
+std::cerr << "kruskal_mst.get_total_weight() = " << kruskal_mst.get_total_weight() << "\n";
+for (const WeightedEdge &edge : kruskal_mst.get_edges()) std::cerr << edge.v_ << "-" << edge.w_ << " " << edge.weight_ << "\n";
 
 
@@ -1,3 +1,7 @@
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 struct Vertex
 {
     Vertex(const int x, const int y) : x_(x), y_(y) {}
@@ -202,6 +206,358 @@ void build_mst_prim_cached()
     }
 }
 
+//Standard dense Prim, O(n^2): every vertex outside the MST keeps its squared distance to the closest MST vertex, which
+//is updated against only the vertex added last, in the same pass that finds the next vertex to add. The vertices
+//outside the MST are kept at the front of structure-of-arrays coordinates (the added one is swapped with the last), so
+//the pass reads only contiguous ints; with AVX2 it handles 8 vertices per step, the lanes past the end masked off.
+//Squared distances are int, like the other Prim versions.
+
+std::vector<int> prim_x_, prim_y_;   //Coordinates of the vertices outside the MST.
+std::vector<int> prim_vi_;           //Their indices in vertices_.
+std::vector<int> prim_min_dist_sq_;  //Their squared distances to the closest MST vertex.
+std::vector<int> prim_closest_vi_;   //That MST vertex.
+
+void build_mst_prim_dense()
+{
+    edges_.clear();
+    edges_.reserve(N_);
+    if (N_ <= 0) return;
+    
+    const int padded_n = (N_ + 7) & ~7;
+    prim_x_.assign(padded_n, 0);
+    prim_y_.assign(padded_n, 0);
+    prim_vi_.assign(padded_n, -1);
+    prim_min_dist_sq_.assign(padded_n, std::numeric_limits<int>::max());
+    prim_closest_vi_.assign(padded_n, -1);
+    
+    for (int vi=0; vi<N_; ++vi)
+    {
+        prim_x_[vi] = vertices_[vi].x_;
+        prim_y_[vi] = vertices_[vi].y_;
+        prim_vi_[vi] = vi;
+    }
+    
+    //Start with vertex 0 in the MST.
+    int num_outside = N_;
+    int added = 0;
+    
+    for (;;)
+    {
+        //Remove slot added from the vertices outside the MST.
+        const int added_vi = prim_vi_[added];
+        const int added_x = prim_x_[added];
+        const int added_y = prim_y_[added];
+        
+        --num_outside;
+        prim_x_[added] = prim_x_[num_outside];
+        prim_y_[added] = prim_y_[num_outside];
+        prim_vi_[added] = prim_vi_[num_outside];
+        prim_min_dist_sq_[added] = prim_min_dist_sq_[num_outside];
+        prim_closest_vi_[added] = prim_closest_vi_[num_outside];
+        
+        if (num_outside == 0) break;
+        
+        int best_i = -1;
+        int best_dist_sq = std::numeric_limits<int>::max();
+        int i = 0;
+        
+#if defined(__AVX2__)
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i end_i = _mm256_set1_epi32(num_outside);
+        const __m256i max_dist_sq = _mm256_set1_epi32(std::numeric_limits<int>::max());
+        const __m256i x = _mm256_set1_epi32(added_x);
+        const __m256i y = _mm256_set1_epi32(added_y);
+        const __m256i vi = _mm256_set1_epi32(added_vi);
+        __m256i best_dist_sq_8 = max_dist_sq;
+        __m256i best_i_8 = _mm256_set1_epi32(-1);
+        
+        for (; i<num_outside; i+=8)
+        {
+            const __m256i i_8 = _mm256_add_epi32(_mm256_set1_epi32(i), lane);
+            const __m256i is_outside = _mm256_cmpgt_epi32(end_i, i_8);
+            
+            const __m256i dx = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) &prim_x_[i]), x);
+            const __m256i dy = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) &prim_y_[i]), y);
+            const __m256i dist_sq = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+            
+            const __m256i min_dist_sq = _mm256_loadu_si256((const __m256i *) &prim_min_dist_sq_[i]);
+            const __m256i is_closer = _mm256_and_si256(_mm256_cmpgt_epi32(min_dist_sq, dist_sq), is_outside);
+            const __m256i new_min_dist_sq = _mm256_blendv_epi8(min_dist_sq, dist_sq, is_closer);
+            _mm256_storeu_si256((__m256i *) &prim_min_dist_sq_[i], new_min_dist_sq);
+            const __m256i closest_vi = _mm256_loadu_si256((const __m256i *) &prim_closest_vi_[i]);
+            _mm256_storeu_si256((__m256i *) &prim_closest_vi_[i], _mm256_blendv_epi8(closest_vi, vi, is_closer));
+            
+            //Per lane argmin, the masked lanes count as max.
+            const __m256i candidate_dist_sq = _mm256_blendv_epi8(max_dist_sq, new_min_dist_sq, is_outside);
+            const __m256i is_better = _mm256_cmpgt_epi32(best_dist_sq_8, candidate_dist_sq);
+            best_dist_sq_8 = _mm256_blendv_epi8(best_dist_sq_8, candidate_dist_sq, is_better);
+            best_i_8 = _mm256_blendv_epi8(best_i_8, i_8, is_better);
+        }
+        
+        alignas(32) int lane_dist_sq[8], lane_i[8];
+        _mm256_store_si256((__m256i *) lane_dist_sq, best_dist_sq_8);
+        _mm256_store_si256((__m256i *) lane_i, best_i_8);
+        for (int l=0; l<8; ++l)
+        {
+            if ((lane_i[l] >= 0) && ((lane_dist_sq[l] < best_dist_sq) || ((lane_dist_sq[l] == best_dist_sq) && (lane_i[l] < best_i))))
+            {
+                best_dist_sq = lane_dist_sq[l];
+                best_i = lane_i[l];
+            }
+        }
+#endif
+        
+        for (; i<num_outside; ++i)
+        {
+            const int dx = prim_x_[i] - added_x;
+            const int dy = prim_y_[i] - added_y;
+            const int dist_sq = dx*dx + dy*dy;
+            
+            if (dist_sq < prim_min_dist_sq_[i])
+            {
+                prim_min_dist_sq_[i] = dist_sq;
+                prim_closest_vi_[i] = added_vi;
+            }
+            
+            if ((best_i < 0) || (prim_min_dist_sq_[i] < best_dist_sq))
+            {
+                best_dist_sq = prim_min_dist_sq_[i];
+                best_i = i;
+            }
+        }
+        
+        edges_.emplace_back(prim_closest_vi_[best_i], prim_vi_[best_i]);
+        added = best_i;
+    }
+}
+
+//Euclidean MST with k-d tree Boruvka, O(n log n) expected. Boruvka rounds: every component finds its shortest edge to another component with nearest
+//neighbour queries in a k-d tree of the vertices, then the components are joined along those edges, so each round at
+//least halves the number of components. The queries of a component's vertices share the component's best distance as
+//their pruning bound, and tree nodes whose vertices are all in the querying component are skipped, so the later rounds
+//(few large components) are cheap. Distances are squared int64_t, so large W_ x H_ don't overflow.
+
+struct KDNode
+{
+    int begin_, end_;                  //Range of kd_order_ (and kd_x_, kd_y_).
+    int left_, right_;                 //Child nodes, -1 for a leaf.
+    int min_x_, min_y_, max_x_, max_y_;//Bounding box.
+    int component_;                    //Component of all the node's vertices, -1 if mixed.
+};
+
+const int kd_leaf_size_ = 16;
+
+std::vector<KDNode> kd_nodes_;
+std::vector<int> kd_order_;     //Vertex indices, ordered so that the vertices of every node are contiguous.
+std::vector<int> kd_x_, kd_y_;  //Coordinates in kd_order_.
+std::vector<int> kd_component_; //Component of each vertex in kd_order_, for the current round.
+std::vector<int> kd_nearest_;   //Nearest vertex outside the component found in a previous round, or -1.
+std::vector<int64_t> kd_nearest_dist_sq_; //Its squared distance, a lower bound for the next one if it joined.
+std::vector<int> component_parent_;
+
+int find_component(int vi)
+{
+    while (component_parent_[vi] != vi)
+    {
+        component_parent_[vi] = component_parent_[component_parent_[vi]];
+        vi = component_parent_[vi];
+    }
+    return vi;
+}
+
+int build_kd_tree(const int begin, const int end)
+{
+    KDNode node;
+    node.begin_ = begin; node.end_ = end;
+    node.left_ = node.right_ = -1;
+    node.min_x_ = node.min_y_ = std::numeric_limits<int>::max();
+    node.max_x_ = node.max_y_ = std::numeric_limits<int>::min();
+    node.component_ = -1;
+    
+    for (int i=begin; i<end; ++i)
+    {
+        const Vertex &V = vertices_[kd_order_[i]];
+        node.min_x_ = std::min(node.min_x_, V.x_); node.max_x_ = std::max(node.max_x_, V.x_);
+        node.min_y_ = std::min(node.min_y_, V.y_); node.max_y_ = std::max(node.max_y_, V.y_);
+    }
+    
+    const int node_index = kd_nodes_.size();
+    kd_nodes_.push_back(node);
+    
+    if ((end - begin) > kd_leaf_size_)
+    {//Split at the median of the wider side.
+        const bool split_x = (node.max_x_ - node.min_x_) >= (node.max_y_ - node.min_y_);
+        const int mid = begin + (end - begin) / 2;
+        std::nth_element(kd_order_.begin() + begin, kd_order_.begin() + mid, kd_order_.begin() + end,
+                         [split_x](const int a, const int b) {
+                             return split_x ? (vertices_[a].x_ < vertices_[b].x_) : (vertices_[a].y_ < vertices_[b].y_);
+                         });
+        
+        const int left = build_kd_tree(begin, mid);
+        const int right = build_kd_tree(mid, end);
+        kd_nodes_[node_index].left_ = left;
+        kd_nodes_[node_index].right_ = right;
+    }
+    
+    return node_index;
+}
+
+//Squared distance from (x, y) to the node's bounding box.
+ALWAYS_INLINE int64_t calc_box_dist_sq(const KDNode &node, const int x, const int y)
+{
+    const int64_t dx = (x < node.min_x_) ? (node.min_x_ - x) : ((x > node.max_x_) ? (x - node.max_x_) : 0);
+    const int64_t dy = (y < node.min_y_) ? (node.min_y_ - y) : ((y > node.max_y_) ? (y - node.max_y_) : 0);
+    return dx*dx + dy*dy;
+}
+
+//Nearest vertex (kd_order_ index) to kd vertex i that is not in component c, if closer than best_dist_sq.
+void find_nearest_other_component(const int i, const int c, int64_t &best_dist_sq, int &best_j)
+{
+    const int x = kd_x_[i];
+    const int y = kd_y_[i];
+    std::pair<int, int64_t> stack[128]; //Nodes to visit and their box distances.
+    int stack_size = 0;
+    stack[stack_size++] = std::make_pair(0, calc_box_dist_sq(kd_nodes_[0], x, y));
+    
+    while (stack_size > 0)
+    {
+        --stack_size;
+        if (stack[stack_size].second >= best_dist_sq) continue;
+        const KDNode &node = kd_nodes_[stack[stack_size].first];
+        if (node.component_ == c) continue;
+        
+        if (node.left_ < 0)
+        {
+            for (int j=node.begin_; j<node.end_; ++j)
+            {
+                if (kd_component_[j] != c)
+                {
+                    const int64_t dx = kd_x_[j] - x;
+                    const int64_t dy = kd_y_[j] - y;
+                    const int64_t dist_sq = dx*dx + dy*dy;
+                    if (dist_sq < best_dist_sq) {best_dist_sq = dist_sq; best_j = j;}
+                }
+            }
+        }
+        else
+        {//Visit the nearer child first (pushed last).
+            const int64_t left_dist_sq = calc_box_dist_sq(kd_nodes_[node.left_], x, y);
+            const int64_t right_dist_sq = calc_box_dist_sq(kd_nodes_[node.right_], x, y);
+            if (left_dist_sq <= right_dist_sq)
+            {
+                stack[stack_size++] = std::make_pair(node.right_, right_dist_sq);
+                stack[stack_size++] = std::make_pair(node.left_, left_dist_sq);
+            }
+            else
+            {
+                stack[stack_size++] = std::make_pair(node.left_, left_dist_sq);
+                stack[stack_size++] = std::make_pair(node.right_, right_dist_sq);
+            }
+        }
+    }
+}
+
+void build_mst_kd_boruvka()
+{
+    const int n = vertices_.size();
+    edges_.clear();
+    edges_.reserve(n);
+    
+    kd_order_.resize(n);
+    for (int vi=0; vi<n; ++vi) kd_order_[vi] = vi;
+    kd_nodes_.clear();
+    kd_nodes_.reserve(4 * (n / kd_leaf_size_ + 1));
+    if (n > 0) build_kd_tree(0, n);
+    
+    kd_x_.resize(n); kd_y_.resize(n);
+    for (int i=0; i<n; ++i) {kd_x_[i] = vertices_[kd_order_[i]].x_; kd_y_[i] = vertices_[kd_order_[i]].y_;}
+    
+    component_parent_.resize(n);
+    for (int vi=0; vi<n; ++vi) component_parent_[vi] = vi;
+    kd_component_.resize(n);
+    
+    kd_nearest_.assign(n, -1);
+    kd_nearest_dist_sq_.assign(n, 0);
+    
+    std::vector<int64_t> component_best_dist_sq(n);
+    std::vector<int> component_best_i(n), component_best_j(n);
+    
+    while (int(edges_.size()) < (n - 1))
+    {
+        for (int i=0; i<n; ++i) kd_component_[i] = find_component(kd_order_[i]);
+        
+        //Children are after their parent, so a reverse pass sets the component of every node from its children.
+        for (int ni=int(kd_nodes_.size())-1; ni>=0; --ni)
+        {
+            KDNode &node = kd_nodes_[ni];
+            if (node.left_ < 0)
+            {
+                node.component_ = kd_component_[node.begin_];
+                for (int i=node.begin_+1; i<node.end_; ++i)
+                {
+                    if (kd_component_[i] != node.component_) {node.component_ = -1; break;}
+                }
+            }
+            else
+            {
+                node.component_ = (kd_nodes_[node.left_].component_ == kd_nodes_[node.right_].component_) ? kd_nodes_[node.left_].component_ : -1;
+            }
+        }
+        
+        for (int i=0; i<n; ++i)
+        {
+            const int c = kd_component_[i];
+            component_best_dist_sq[c] = std::numeric_limits<int64_t>::max();
+            component_best_j[c] = -1;
+        }
+        
+        for (int i=0; i<n; ++i)
+        {
+            const int c = kd_component_[i];
+            int best_j = kd_nearest_[i];
+            
+            if ((best_j >= 0) && (kd_component_[best_j] != c))
+            {//Still the nearest vertex outside the component, which only grew.
+                if (kd_nearest_dist_sq_[i] >= component_best_dist_sq[c]) continue;
+                component_best_dist_sq[c] = kd_nearest_dist_sq_[i];
+            }
+            else
+            {//The distance to the nearest vertex outside the component never decreases, so the old one is a lower bound.
+                if (kd_nearest_dist_sq_[i] >= component_best_dist_sq[c]) {kd_nearest_[i] = -1; continue;}
+                best_j = -1;
+                find_nearest_other_component(i, c, component_best_dist_sq[c], best_j);
+                kd_nearest_[i] = best_j;
+                if (best_j < 0) continue;
+                kd_nearest_dist_sq_[i] = component_best_dist_sq[c];
+            }
+            
+            component_best_i[c] = i;
+            component_best_j[c] = best_j;
+        }
+        
+        const int num_edges = edges_.size();
+        for (int i=0; i<n; ++i)
+        {
+            const int c = kd_component_[i];
+            if ((c == kd_order_[i]) && (component_best_j[c] >= 0))
+            {//Once per component (its root).
+                const int vi = kd_order_[component_best_i[c]];
+                const int wi = kd_order_[component_best_j[c]];
+                const int root_v = find_component(vi);
+                const int root_w = find_component(wi);
+                
+                if (root_v != root_w)
+                {
+                    component_parent_[root_v] = root_w;
+                    edges_.emplace_back(vi, wi);
+                }
+            }
+        }
+        
+        if (int(edges_.size()) == num_edges) break;
+    }
+}
+
 //======================================
 //======================================
 //======================================
@@ -226,8 +582,26 @@ for (;;) {
     render_graph(0, 255, 0);
 #endif
     
+    const double start_time_prim_dense = TCTimer::get_tsc_time();
+    build_mst_prim_dense();
+    const double end_time_prim_dense = TCTimer::get_tsc_time();
+    
+#ifdef TCSDL
+    render_graph(255, 255, 0);
+#endif
+    
+    const double start_time_kd_boruvka = TCTimer::get_tsc_time();
+    build_mst_kd_boruvka();
+    const double end_time_kd_boruvka = TCTimer::get_tsc_time();
+    
+#ifdef TCSDL
+    render_graph(0, 0, 255);
+#endif
+    
     DBN(end_time_prim_naive - start_time_prim_naive)
     DBN(end_time_prim_cached - start_time_prim_cached)
+    DBN(end_time_prim_dense - start_time_prim_dense)
+    DBN(end_time_kd_boruvka - start_time_kd_boruvka)
 
 
 
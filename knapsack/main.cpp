@@ -2,6 +2,11 @@
 
 #include "../time/tc_timer.h"
 #include "../random/tc_random_funcs.h"
+#include "../platform_info/tc_huge_pages.h"
+#include "tc_knapsack_dyn_prog.h"
+#include "tc_knapsack_simd.h"
+#include "tc_knapsack_branch_bound.h"
+#include "tc_knapsack.h"
 
 #include <iostream>
 #include <vector>
@@ -61,26 +66,31 @@ std::vector<int> knapsack_greedy(const std::vector<std::pair<int, int>> &weight_
 
 
 int64_t **value_array;
+TCHugePageBuffer<int64_t> value_table; // The rows of value_array, in one block of (transparent) huge pages.
 
-//! Allocate the mem for the dynamic programming solution.
-void alloc_dyn_prog_mem(const int weight_value_vect_size, const int W_)
+//! Allocate the mem for the dynamic programming solution. Returns false if the table could not be mapped.
+bool alloc_dyn_prog_mem(const int weight_value_vect_size, const int W_)
 {
+    if (!value_table.allocate(size_t(weight_value_vect_size+1) * (W_+1), tc_huge_pages::PageKind::transparent_huge)) {
+        std::cout << "alloc_dyn_prog_mem: could not allocate " << ((weight_value_vect_size+1) * (W_+1) * sizeof(int64_t)) / (1024.0 * 1024.0) << "MB.\n";
+        return false;
+    }
+    
     value_array = new int64_t *[weight_value_vect_size+1];
     
     for (int i=0; i <= weight_value_vect_size; ++i) {
-        value_array[i] = new int64_t[W_ + 1];
+        value_array[i] = value_table.data() + size_t(i) * (W_+1);
     }
-    std::cout << "alloc_dyn_prog_mem: " << ((weight_value_vect_size+1) * (W_+1) * sizeof(int64_t)) / (1024.0 * 1024.0) << "MB allocated.\n";
+    std::cout << "alloc_dyn_prog_mem: " << ((weight_value_vect_size+1) * (W_+1) * sizeof(int64_t)) / (1024.0 * 1024.0) << "MB allocated"
+              << " (" << tc_huge_pages::get_page_kind_name(value_table.get_page_kind()) << " pages).\n";
+    return true;
 }
 
 //! free the mem used for the dynamic programming solution.
-void free_dyn_prog_mem(const int weight_value_vect_size)
+void free_dyn_prog_mem(const int /*weight_value_vect_size*/)
 {
-    for (int i=0; i <= weight_value_vect_size; ++i) {
-        delete [] value_array[i];
-    }
-    
     delete [] value_array;
+    value_table.release();
 }
 
 //! Solve the knapsack problem using dynamic programming.
@@ -210,32 +220,168 @@ int main(void) // See post at https://bduvenhage.me/algorithms/dynamic%20program
         DBS(value_greedy)
         DBN(time_greedy)
     }
+    {// == Greedy with one sort by value density
+        const double start_time_greedy = TCTimer::get_time();
+        
+        const std::vector<int> object_ids_greedy_sorted = tc_knapsack::knapsack_greedy_sorted(weight_value_vect, W);
+        
+        const int64_t value_greedy_sorted = calc_knapsack_value(object_ids_greedy_sorted, weight_value_vect);
+        const double end_time_greedy = TCTimer::get_time();
+        const double time_greedy_sorted = end_time_greedy - start_time_greedy;
+        const int64_t fractional_upper_bound = tc_knapsack::fractional_upper_bound(weight_value_vect, W);
+        DBS(value_greedy_sorted)
+        DBS(time_greedy_sorted)
+        DBN(fractional_upper_bound)
+    }
+    {// == Branch and bound with fractional bounds
+        const double start_time_bb = TCTimer::get_time();
+        bool is_optimal_bb = false;
+        uint64_t num_nodes_bb = 0;
+        
+        const std::vector<int> object_ids_bb = tc_knapsack::knapsack_branch_and_bound(weight_value_vect, W, 100000000,
+                                                                                      &is_optimal_bb, &num_nodes_bb);
+        
+        const int64_t value_bb = calc_knapsack_value(object_ids_bb, weight_value_vect);
+        const double end_time_bb = TCTimer::get_time();
+        const double time_bb = end_time_bb - start_time_bb;
+        DBS(value_bb)
+        DBS(time_bb)
+        DBS(is_optimal_bb)
+        DBN(num_nodes_bb)
+    }
+    
+    
+    if (alloc_dyn_prog_mem(weight_value_vect.size(), W)) {
+        {// == DP 1
+            const double start_time_dp = TCTimer::get_time();
+            
+            const std::vector<int> object_ids_dyn_prog_simple = knapsack_dyn_prog(weight_value_vect, W);
+            
+            const int64_t value_dp = calc_knapsack_value(object_ids_dyn_prog_simple, weight_value_vect);
+            const double end_time_dp = TCTimer::get_time();
+            const double time_dp = end_time_dp - start_time_dp;
+            DBS(value_dp)
+            DBN(time_dp)
+        }
+        {// == DP 2 - Do again to check performance after mem available to process.
+            const double start_time_dp = TCTimer::get_time();
+            
+            const std::vector<int> object_ids_dyn_prog_simple = knapsack_dyn_prog(weight_value_vect, W);
+            
+            const int64_t value_dp = calc_knapsack_value(object_ids_dyn_prog_simple, weight_value_vect);
+            const double end_time_dp = TCTimer::get_time();
+            const double time_dp = end_time_dp - start_time_dp;
+            DBS(value_dp)
+            DBN(time_dp)
+        }
+        free_dyn_prog_mem(weight_value_vect.size());
+    }
     
     
-    alloc_dyn_prog_mem(weight_value_vect.size(), W);
-    {// == DP 1
+    {// == DP with a rolling row and Hirschberg reconstruction.
         const double start_time_dp = TCTimer::get_time();
         
-        const std::vector<int> object_ids_dyn_prog_simple = knapsack_dyn_prog(weight_value_vect, W);
+        const std::vector<int> object_ids_hirschberg = tc_knapsack::knapsack_dyn_prog_hirschberg(weight_value_vect, W);
         
-        const int64_t value_dp = calc_knapsack_value(object_ids_dyn_prog_simple, weight_value_vect);
+        const int64_t value_dp_hirschberg = calc_knapsack_value(object_ids_hirschberg, weight_value_vect);
         const double end_time_dp = TCTimer::get_time();
-        const double time_dp = end_time_dp - start_time_dp;
-        DBS(value_dp)
-        DBN(time_dp)
+        const double time_dp_hirschberg = end_time_dp - start_time_dp;
+        const double mem_MB_hirschberg = tc_knapsack::get_hirschberg_memory_usage(weight_value_vect.size(), W) / (1024.0 * 1024.0);
+        DBS(value_dp_hirschberg)
+        DBS(time_dp_hirschberg)
+        DBN(mem_MB_hirschberg)
     }
-    {// == DP 2 - Do again to check performance after mem available to process.
+    {// == DP with a rolling row and a bit packed decision matrix.
         const double start_time_dp = TCTimer::get_time();
         
-        const std::vector<int> object_ids_dyn_prog_simple = knapsack_dyn_prog(weight_value_vect, W);
+        const std::vector<int> object_ids_bit_matrix = tc_knapsack::knapsack_dyn_prog_bit_matrix(weight_value_vect, W);
         
-        const int64_t value_dp = calc_knapsack_value(object_ids_dyn_prog_simple, weight_value_vect);
+        const int64_t value_dp_bit_matrix = calc_knapsack_value(object_ids_bit_matrix, weight_value_vect);
         const double end_time_dp = TCTimer::get_time();
-        const double time_dp = end_time_dp - start_time_dp;
-        DBS(value_dp)
-        DBN(time_dp)
+        const double time_dp_bit_matrix = end_time_dp - start_time_dp;
+        const double mem_MB_bit_matrix = tc_knapsack::get_bit_matrix_memory_usage(weight_value_vect.size(), W) / (1024.0 * 1024.0);
+        DBS(value_dp_bit_matrix)
+        DBS(time_dp_bit_matrix)
+        DBN(mem_MB_bit_matrix)
+    }
+    {// == DP with SIMD/multithreaded row updates and Hirschberg reconstruction.
+        const double start_time_dp = TCTimer::get_time();
+        
+        const std::vector<int> object_ids_simd = tc_knapsack::knapsack_dyn_prog_simd(weight_value_vect, W);
+        
+        const int64_t value_dp_simd = calc_knapsack_value(object_ids_simd, weight_value_vect);
+        const double end_time_dp = TCTimer::get_time();
+        const double time_dp_simd = end_time_dp - start_time_dp;
+        const bool int32_cells = tc_knapsack::values_fit_int32(weight_value_vect);
+        DBS(value_dp_simd)
+        DBS(time_dp_simd)
+        DBN(int32_cells)
+    }
+    {// == The unified solver API on the 0/1, bounded (2 of each), unbounded and two constraint versions of the problem.
+        using namespace tc_knapsack;
+        
+        std::vector<std::vector<int>> weights_2d(2);
+        std::vector<int> values;
+        for (const auto &object : weight_value_vect) {
+            weights_2d[0].push_back(object.first);
+            weights_2d[1].push_back(1); // Second constraint: at most W/2 objects.
+            values.push_back(object.second);
+        }
+        
+        const KnapsackProblem problems[] = {
+            KnapsackProblem::make_zero_one(weight_value_vect, W),
+            KnapsackProblem::make_bounded(weight_value_vect, std::vector<int>(weight_value_vect.size(), 2), W),
+            KnapsackProblem::make_unbounded(weight_value_vect, W),
+            KnapsackProblem::make_multi_constraint(weights_2d, values, {W, std::max(W / 2, 1)})
+        };
+        const char * const problem_names[] = {"zero_one", "bounded", "unbounded", "multi_constraint"};
+        
+        for (int p=0; p<4; ++p) {
+            const KnapsackSolution solution = solve_knapsack(problems[p]);
+            std::cout << problem_names[p] << ": value = " << solution.value_
+                      << "  method = " << get_knapsack_method_name(solution.stats_.method_)
+                      << "  is_optimal = " << solution.stats_.is_optimal_
+                      << "  upper_bound = " << solution.stats_.upper_bound_
+                      << "  time = " << solution.stats_.solve_time_ << "\n";
+        }
+    }
+    {// == Branch and bound, sorted greedy and the fractional bound against brute force on small random instances that
+     //    include zero weight and zero value objects.
+        int num_brute_force_mismatches = 0;
+        
+        for (int instance=0; instance<2000; ++instance) {
+            const int n = 1 + int(rng.next(12));
+            const int brute_force_W = int(rng.next(60));
+            std::vector<std::pair<int, int>> objects;
+            for (int i=0; i<n; ++i) {
+                const int kind = int(rng.next(5)); // 0: zero weight, 1: zero value, otherwise random.
+                objects.push_back(std::make_pair((kind == 0) ? 0 : 1 + int(rng.next(20)), (kind == 1) ? 0 : int(rng.next(30))));
+            }
+            
+            int64_t best_value = 0;
+            for (int subset=0; subset<(1<<n); ++subset) {
+                int64_t weight = 0, value = 0;
+                for (int i=0; i<n; ++i) {
+                    if ((subset >> i) & 1) {weight += objects[i].first; value += objects[i].second;}
+                }
+                if ((weight <= brute_force_W) && (value > best_value)) best_value = value;
+            }
+            
+            bool is_optimal = false;
+            const std::vector<int> object_ids_bb = tc_knapsack::knapsack_branch_and_bound(objects, brute_force_W, 100000000, &is_optimal);
+            const std::vector<int> object_ids_greedy = tc_knapsack::knapsack_greedy_sorted(objects, brute_force_W);
+            int64_t weight_bb = 0, weight_greedy = 0;
+            for (const int id : object_ids_bb) weight_bb += objects[id].first;
+            for (const int id : object_ids_greedy) weight_greedy += objects[id].first;
+            
+            if ((calc_knapsack_value(object_ids_bb, objects) != best_value) || !is_optimal || (weight_bb > brute_force_W) ||
+                (weight_greedy > brute_force_W) || (tc_knapsack::fractional_upper_bound(objects, brute_force_W) < best_value)) {
+                ++num_brute_force_mismatches;
+            }
+        }
+        
+        DBN(num_brute_force_mismatches)
     }
-    free_dyn_prog_mem(weight_value_vect.size());
 
     return 0;
 }
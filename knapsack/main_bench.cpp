@@ -0,0 +1,165 @@
+// Benchmark of the knapsack solvers on Pisinger style instances (see tc_knapsack_instances.h).
+// Every solver is timed on each class, number of objects n and weight range R (capacity = half the total weight) and
+// one CSV line per run is written: value, time, memory and the optimality gap. The gap is relative to the optimum if
+// an exact solver finished, otherwise to the fractional upper bound (reference column "upper_bound").
+// DP solvers are skipped when n*(W+1) is more than max_dp_cells, the full table also when it needs more than 1GB.
+// Usage: knapsack_bench [csv_file] [max_dp_cells]
+
+#include "../defines/tc_defines.h"
+
+#include "../time/tc_timer.h"
+#include "../random/tc_random_funcs.h"
+#include "tc_knapsack_dyn_prog.h"
+#include "tc_knapsack_simd.h"
+#include "tc_knapsack_branch_bound.h"
+#include "tc_knapsack.h"
+#include "tc_knapsack_instances.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdlib>
+
+
+TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321);
+
+//! One timed run of a solver on an instance.
+struct BenchResult {
+    const char *solver_ = "";
+    int64_t value_ = 0;
+    double time_ = 0.0;
+    size_t memory_bytes_ = 0;
+    bool is_optimal_ = false; //!< The solver proved its value optimal.
+};
+
+int64_t calc_knapsack_value(const std::vector<int> &object_ids, const tc_knapsack::WeightValueVect &weight_value_vect_) {
+    int64_t knapsack_value = 0;
+    for (const int object_id : object_ids) knapsack_value += weight_value_vect_[object_id].second;
+    return knapsack_value;
+}
+
+//! Time a solver that returns object ids.
+BenchResult run_solver(const char * const solver, const std::function<std::vector<int>()> &solve,
+                       const tc_knapsack::WeightValueVect &weight_value_vect_, const size_t memory_bytes, const bool is_optimal) {
+    BenchResult result;
+    result.solver_ = solver;
+
+    const double start_time = TCTimer::get_time();
+    const std::vector<int> object_ids = solve();
+    result.time_ = TCTimer::get_time() - start_time;
+
+    result.value_ = calc_knapsack_value(object_ids, weight_value_vect_);
+    result.memory_bytes_ = memory_bytes;
+    result.is_optimal_ = is_optimal;
+    return result;
+}
+
+//! Run every solver that fits the limits on one instance.
+std::vector<BenchResult> bench_instance(const tc_knapsack::WeightValueVect &weight_value_vect_, const int W_,
+                                        const uint64_t max_dp_cells) {
+    using namespace tc_knapsack;
+    const int n = int(weight_value_vect_.size());
+    const uint64_t num_cells = uint64_t(n) * (uint64_t(W_) + 1);
+    const size_t max_table_bytes = size_t(1) << 30;
+    std::vector<BenchResult> results;
+
+    results.push_back(run_solver("greedy_sorted", [&]() {return knapsack_greedy_sorted(weight_value_vect_, W_);},
+                                 weight_value_vect_, n * sizeof(int), false));
+
+    {
+        bool is_optimal = false;
+        results.push_back(run_solver("branch_and_bound", [&]() {
+            return knapsack_branch_and_bound(weight_value_vect_, W_, 10000000, &is_optimal);
+        }, weight_value_vect_, n * (sizeof(int) + 5 * sizeof(int64_t)), false));
+        results.back().is_optimal_ = is_optimal;
+    }
+
+    if (num_cells <= max_dp_cells) {
+        if (get_table_memory_usage(n, W_) <= max_table_bytes) {
+            results.push_back(run_solver("dp_table", [&]() {return knapsack_dyn_prog_table(weight_value_vect_, W_);},
+                                         weight_value_vect_, get_table_memory_usage(n, W_), true));
+        }
+        results.push_back(run_solver("dp_hirschberg", [&]() {return knapsack_dyn_prog_hirschberg(weight_value_vect_, W_);},
+                                     weight_value_vect_, get_hirschberg_memory_usage(n, W_), true));
+        results.push_back(run_solver("dp_bit_matrix", [&]() {return knapsack_dyn_prog_bit_matrix(weight_value_vect_, W_);},
+                                     weight_value_vect_, get_bit_matrix_memory_usage(n, W_), true));
+        const size_t cell_bytes = values_fit_int32(weight_value_vect_) ? sizeof(int32_t) : sizeof(int64_t);
+        results.push_back(run_solver("dp_simd", [&]() {return knapsack_dyn_prog_simd(weight_value_vect_, W_);},
+                                     weight_value_vect_, 3 * (size_t(W_) + 1) * cell_bytes, true));
+    }
+
+    {// The unified API with the automatic choice of method.
+        BenchResult result;
+        result.solver_ = "automatic";
+        const double start_time = TCTimer::get_time();
+        const KnapsackSolution solution = solve_knapsack(KnapsackProblem::make_zero_one(weight_value_vect_, W_));
+        result.time_ = TCTimer::get_time() - start_time;
+        result.value_ = solution.value_;
+        result.memory_bytes_ = solution.stats_.memory_bytes_;
+        result.is_optimal_ = solution.stats_.is_optimal_;
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const double EXP_TSC_FREQ = 2.89992e+09;
+    TCTimer::init_timer(EXP_TSC_FREQ);
+
+    std::ofstream csv_file;
+    if (argc > 1) {
+        csv_file.open(argv[1]);
+        if (!csv_file) {std::cerr << "Could not open " << argv[1] << ".\n"; return 1;}
+    }
+    std::ostream &csv = (argc > 1) ? csv_file : std::cout;
+    const uint64_t max_dp_cells = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : (uint64_t(1) << 32);
+
+    const tc_knapsack::InstanceClass instance_classes[] = {
+        tc_knapsack::InstanceClass::uncorrelated, tc_knapsack::InstanceClass::weakly_correlated,
+        tc_knapsack::InstanceClass::strongly_correlated, tc_knapsack::InstanceClass::subset_sum
+    };
+    const int ns[] = {100, 1000, 10000};
+    const int Rs[] = {100, 1000, 10000};
+
+    csv << "class,n,R,W,solver,value,time_s,memory_bytes,is_optimal,gap,gap_reference\n";
+
+    for (const tc_knapsack::InstanceClass instance_class : instance_classes) {
+        for (const int n : ns) {
+            for (const int R : Rs) {
+                tc_knapsack::WeightValueVect weight_value_vect;
+                const int W = tc_knapsack::make_knapsack_instance(rng, instance_class, n, R, 0.5, weight_value_vect);
+
+                const std::vector<BenchResult> results = bench_instance(weight_value_vect, W, max_dp_cells);
+
+                // The gap is measured from the optimum if any solver proved it, else from the fractional bound.
+                int64_t reference_value = tc_knapsack::fractional_upper_bound(weight_value_vect, W);
+                bool is_reference_optimal = false;
+                for (const BenchResult &result : results) {
+                    if (result.is_optimal_) {
+                        if (is_reference_optimal && (result.value_ != reference_value)) {
+                            std::cerr << "Solvers disagree on the optimum: " << result.solver_ << " " << result.value_
+                                      << " vs " << reference_value << "\n";
+                        }
+                        reference_value = result.value_;
+                        is_reference_optimal = true;
+                    }
+                }
+
+                for (const BenchResult &result : results) {
+                    const double gap = (reference_value > 0) ? double(reference_value - result.value_) / reference_value : 0.0;
+                    csv << tc_knapsack::get_instance_class_name(instance_class) << "," << n << "," << R << "," << W << ","
+                        << result.solver_ << "," << result.value_ << "," << result.time_ << "," << result.memory_bytes_ << ","
+                        << result.is_optimal_ << "," << gap << "," << (is_reference_optimal ? "optimal" : "upper_bound") << "\n";
+                }
+                csv.flush();
+            }
+        }
+    }
+
+    return 0;
+}
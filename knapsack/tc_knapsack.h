@@ -0,0 +1,494 @@
+#ifndef TC_KNAPSACK_H
+#define TC_KNAPSACK_H 1
+
+#include "../defines/tc_defines.h"
+#include "../time/tc_timer.h"
+#include "tc_knapsack_dyn_prog.h"
+#include "tc_knapsack_simd.h"
+#include "tc_knapsack_branch_bound.h"
+
+#include <vector>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+//==========================//
+//=== TC Knapsack Solver ===//
+//==========================//
+/*!
+ * One API for 0/1, bounded, unbounded and multi-constraint knapsack problems.
+ * - Bounded problems are reduced to 0/1 by binary splitting (count c becomes objects of 1, 2, 4, ... copies plus the
+ *   remainder; value x copies must fit in an int). Unbounded problems are solved with their own O(nW) DP, or as
+ *   bounded with count floor(W/w) for greedy and branch-and-bound. Zero weight objects are ignored when unbounded.
+ * - Multi-constraint problems use a surrogate relaxation (the constraints summed, each scaled by 1/capacity) for
+ *   the greedy order and the branch-and-bound bound, and a DP over the flattened capacity grid if it is small.
+ * - KnapsackMethod::automatic uses the DP for small instances (n x cells <= small_dp_cells_), otherwise
+ *   branch-and-bound with a budget of max_nodes_; if that doesn't prove optimality the DP is used if
+ *   n x cells <= max_dp_cells_, else the best branch-and-bound solution is returned with is_optimal_ false.
+ * - The solution holds the number of copies taken of each object, its value and the solve statistics
+ *   (method used, optimality, time, nodes, memory and an upper bound for the gap).
+ * EXAMPLE Usage:
+ *   const tc_knapsack::KnapsackProblem problem = tc_knapsack::KnapsackProblem::make_bounded(weight_value_vect, counts, W);
+ *   const tc_knapsack::KnapsackSolution solution = tc_knapsack::solve_knapsack(problem);
+ *   DBS(solution.value_) DBN(tc_knapsack::get_knapsack_method_name(solution.stats_.method_))
+ */
+
+namespace tc_knapsack {
+    enum class KnapsackKind {zero_one, bounded, unbounded, multi_constraint};
+    enum class KnapsackMethod {automatic, greedy, dyn_prog, branch_and_bound};
+
+    const char *get_knapsack_method_name(const KnapsackMethod method) {
+        switch (method) {
+            case KnapsackMethod::automatic: return "automatic";
+            case KnapsackMethod::greedy: return "greedy";
+            case KnapsackMethod::dyn_prog: return "dyn_prog";
+            case KnapsackMethod::branch_and_bound: return "branch_and_bound";
+        }
+        return "?";
+    }
+
+    struct KnapsackProblem {
+        KnapsackKind kind_ = KnapsackKind::zero_one;
+        std::vector<int> values_;                //!< Value of each object.
+        std::vector<std::vector<int>> weights_;  //!< weights_[d][i]: weight of object i in constraint d.
+        std::vector<int> capacities_;            //!< Capacity of each constraint.
+        std::vector<int> counts_;                //!< Copies available of each object (bounded only).
+
+        static KnapsackProblem make_zero_one(const WeightValueVect &weight_value_vect_, const int W_) {
+            KnapsackProblem problem;
+            problem.weights_.resize(1);
+            for (const auto &object : weight_value_vect_) {
+                problem.weights_[0].push_back(object.first);
+                problem.values_.push_back(object.second);
+            }
+            problem.capacities_.push_back(W_);
+            return problem;
+        }
+
+        static KnapsackProblem make_bounded(const WeightValueVect &weight_value_vect_, const std::vector<int> &counts, const int W_) {
+            KnapsackProblem problem = make_zero_one(weight_value_vect_, W_);
+            problem.kind_ = KnapsackKind::bounded;
+            problem.counts_ = counts;
+            return problem;
+        }
+
+        static KnapsackProblem make_unbounded(const WeightValueVect &weight_value_vect_, const int W_) {
+            KnapsackProblem problem = make_zero_one(weight_value_vect_, W_);
+            problem.kind_ = KnapsackKind::unbounded;
+            return problem;
+        }
+
+        static KnapsackProblem make_multi_constraint(const std::vector<std::vector<int>> &weights, const std::vector<int> &values,
+                                                     const std::vector<int> &capacities) {
+            KnapsackProblem problem;
+            problem.kind_ = KnapsackKind::multi_constraint;
+            problem.weights_ = weights;
+            problem.values_ = values;
+            problem.capacities_ = capacities;
+            return problem;
+        }
+
+        int get_num_objects() const noexcept {return int(values_.size());}
+        int get_num_constraints() const noexcept {return int(capacities_.size());}
+    };
+
+    struct KnapsackStats {
+        KnapsackMethod method_ = KnapsackMethod::automatic; //!< The method that produced the solution.
+        bool is_optimal_ = false;
+        double solve_time_ = 0.0;    //!< Seconds.
+        uint64_t num_nodes_ = 0;     //!< Branch-and-bound nodes visited (also when it fell back to the DP).
+        size_t memory_bytes_ = 0;    //!< Working memory of the method used.
+        int64_t upper_bound_ = 0;    //!< LP (or surrogate LP) bound on the optimal value.
+    };
+
+    struct KnapsackSolution {
+        std::vector<int> counts_; //!< Copies taken of each object.
+        int64_t value_ = 0;
+        KnapsackStats stats_;
+
+        //! Objects with at least one copy taken.
+        std::vector<int> get_object_ids() const {
+            std::vector<int> object_ids;
+            for (int i=0; i<int(counts_.size()); ++i) if (counts_[i] > 0) object_ids.push_back(i);
+            return object_ids;
+        }
+    };
+
+    struct KnapsackOptions {
+        KnapsackMethod method_ = KnapsackMethod::automatic;
+        uint64_t max_nodes_ = 10000000;           //!< Branch-and-bound budget.
+        uint64_t small_dp_cells_ = 1 << 20;       //!< automatic: always use the DP up to this many cells.
+        uint64_t max_dp_cells_ = uint64_t(1) << 33; //!< automatic: largest DP after branch-and-bound gave up.
+        int num_threads_ = 0;                     //!< DP threads; 0 for the hardware concurrency.
+    };
+
+    //! A 0/1 object that stands for num_copies_ copies of object id_.
+    struct SplitObject {
+        int id_;
+        int num_copies_;
+    };
+
+    //! Binary splitting of bounded counts into 0/1 objects. Objects with weight > W_ or no value are dropped.
+    void split_counts(const KnapsackProblem &problem, const std::vector<int> &counts,
+                      WeightValueVect &split_weight_value_vect, std::vector<SplitObject> &split_objects) {
+        const int W_ = problem.capacities_[0];
+        for (int i=0; i<problem.get_num_objects(); ++i) {
+            const int64_t weight = problem.weights_[0][i];
+            if ((problem.values_[i] <= 0) || (weight > W_)) continue;
+
+            int remaining = (weight > 0) ? int(std::min<int64_t>(counts[i], W_ / weight)) : counts[i];
+            for (int copies=1; remaining > 0; copies <<= 1) {
+                const int c = std::min(copies, remaining);
+                split_weight_value_vect.push_back(std::make_pair(int(weight * c),
+                                                                 int(std::min<int64_t>(int64_t(problem.values_[i]) * c, INT32_MAX))));
+                split_objects.push_back(SplitObject{i, c});
+                remaining -= c;
+            }
+        }
+    }
+
+    //! Solve a 0/1 problem with a single constraint. Fills method_, is_optimal_, num_nodes_ and memory_bytes_.
+    std::vector<int> solve_zero_one(const WeightValueVect &weight_value_vect_, const int W_, const KnapsackOptions &options,
+                                    KnapsackStats &stats) {
+        const uint64_t num_cells = uint64_t(weight_value_vect_.size()) * (uint64_t(W_) + 1);
+        KnapsackMethod method = options.method_;
+        const size_t cell_bytes = values_fit_int32(weight_value_vect_) ? sizeof(int32_t) : sizeof(int64_t);
+
+        if ((method == KnapsackMethod::automatic) && (num_cells <= options.small_dp_cells_)) method = KnapsackMethod::dyn_prog;
+
+        if (method == KnapsackMethod::greedy) {
+            stats.method_ = method;
+            stats.is_optimal_ = false;
+            stats.memory_bytes_ = weight_value_vect_.size() * sizeof(int);
+            return knapsack_greedy_sorted(weight_value_vect_, W_);
+        }
+
+        if (method != KnapsackMethod::dyn_prog) {
+            bool is_optimal = false;
+            uint64_t num_nodes = 0;
+            const std::vector<int> object_ids = knapsack_branch_and_bound(weight_value_vect_, W_, options.max_nodes_, &is_optimal, &num_nodes);
+            stats.num_nodes_ = num_nodes;
+
+            if (is_optimal || (method == KnapsackMethod::branch_and_bound) || (num_cells > options.max_dp_cells_)) {
+                stats.method_ = KnapsackMethod::branch_and_bound;
+                stats.is_optimal_ = is_optimal;
+                stats.memory_bytes_ = weight_value_vect_.size() * (sizeof(int) + 5 * sizeof(int64_t));
+                return object_ids;
+            }
+        }
+
+        stats.method_ = KnapsackMethod::dyn_prog;
+        stats.is_optimal_ = true;
+        stats.memory_bytes_ = 3 * (size_t(W_) + 1) * cell_bytes; //The engine's two rows and Hirschberg's second row.
+        return knapsack_dyn_prog_simd(weight_value_vect_, W_, options.num_threads_);
+    }
+
+    //! Bounded (or unbounded as bounded) problems via binary splitting.
+    void solve_bounded(const KnapsackProblem &problem, const std::vector<int> &counts, const KnapsackOptions &options,
+                       KnapsackSolution &solution) {
+        WeightValueVect split_weight_value_vect;
+        std::vector<SplitObject> split_objects;
+        split_counts(problem, counts, split_weight_value_vect, split_objects);
+
+        solution.stats_.upper_bound_ = fractional_upper_bound(split_weight_value_vect, problem.capacities_[0]);
+        for (const int j : solve_zero_one(split_weight_value_vect, problem.capacities_[0], options, solution.stats_)) {
+            solution.counts_[split_objects[j].id_] += split_objects[j].num_copies_;
+        }
+    }
+
+    //! Unbounded DP, capacity by capacity so that the choice of each capacity is final when it is used.
+    void solve_unbounded_dyn_prog(const KnapsackProblem &problem, KnapsackSolution &solution) {
+        const int W_ = problem.capacities_[0];
+        const int n = problem.get_num_objects();
+        std::vector<int64_t> best(W_ + 1, 0);   //!< Best value with weight <= w.
+        std::vector<int> choice(W_ + 1, -1);    //!< Last object added at w, or -1 if best[w] == best[w-1].
+
+        for (int w=1; w <= W_; ++w) {
+            best[w] = best[w - 1];
+            for (int i=0; i<n; ++i) {
+                const int weight = problem.weights_[0][i];
+                if ((weight > 0) && (weight <= w) && (best[w - weight] + problem.values_[i] > best[w])) {
+                    best[w] = best[w - weight] + problem.values_[i];
+                    choice[w] = i;
+                }
+            }
+        }
+
+        for (int w=W_; w > 0; ) {
+            if (choice[w] < 0) {--w; continue;}
+            solution.counts_[choice[w]] += 1;
+            w -= problem.weights_[0][choice[w]];
+        }
+
+        solution.stats_.method_ = KnapsackMethod::dyn_prog;
+        solution.stats_.is_optimal_ = true;
+        solution.stats_.memory_bytes_ = (size_t(W_) + 1) * (sizeof(int64_t) + sizeof(int));
+    }
+
+    //! Objects of a multi-constraint problem in surrogate density order.
+    class SurrogateOrderedObjects {
+    public:
+        explicit SurrogateOrderedObjects(const KnapsackProblem &problem) : problem_(problem) {
+            const int n = problem.get_num_objects();
+            const int m = problem.get_num_constraints();
+            std::vector<double> surrogate_weight(n, 0.0);
+
+            for (int i=0; i<n; ++i) {
+                bool can_fit = problem.values_[i] > 0;
+                for (int d=0; d<m; ++d) {
+                    if (problem.weights_[d][i] > problem.capacities_[d]) can_fit = false;
+                    else if (problem.capacities_[d] > 0) surrogate_weight[i] += problem.weights_[d][i] / double(problem.capacities_[d]);
+                }
+                if (can_fit) order_.push_back(i);
+            }
+
+            std::sort(order_.begin(), order_.end(), [&](const int a, const int b) {
+                const double lhs = problem.values_[a] * surrogate_weight[b], rhs = problem.values_[b] * surrogate_weight[a];
+                return (lhs > rhs) || ((lhs == rhs) && (a < b));
+            });
+
+            weight_prefix_.assign(order_.size() + 1, 0.0);
+            value_prefix_.assign(order_.size() + 1, 0);
+            for (size_t j=0; j<order_.size(); ++j) {
+                surrogate_weights_.push_back(surrogate_weight[order_[j]]);
+                weight_prefix_[j + 1] = weight_prefix_[j] + surrogate_weights_[j];
+                value_prefix_[j + 1] = value_prefix_[j] + problem.values_[order_[j]];
+            }
+        }
+
+        //! Surrogate LP bound on the value objects [j, n) can add with the remaining surrogate capacity.
+        int64_t calc_upper_bound(const int j, const double remaining_surrogate) const {
+            const int n = int(order_.size());
+            const double weight_limit = weight_prefix_[j] + remaining_surrogate;
+            const int r = int(std::upper_bound(weight_prefix_.begin() + j + 1, weight_prefix_.end(), weight_limit) - weight_prefix_.begin()) - 1;
+            double bound = double(value_prefix_[r] - value_prefix_[j]);
+            if (r < n) bound += (weight_limit - weight_prefix_[r]) * problem_.values_[order_[r]] / surrogate_weights_[r];
+            return int64_t(std::floor(bound * (1.0 + 1e-12) + 1e-6)); //Round down, but never below the exact bound.
+        }
+
+        ALWAYS_INLINE bool fits(const int j, const std::vector<int64_t> &remaining) const {
+            for (int d=0; d<int(remaining.size()); ++d) if (problem_.weights_[d][order_[j]] > remaining[d]) return false;
+            return true;
+        }
+
+        ALWAYS_INLINE void add(const int j, std::vector<int64_t> &remaining, const int sign) const {
+            for (int d=0; d<int(remaining.size()); ++d) remaining[d] -= sign * int64_t(problem_.weights_[d][order_[j]]);
+        }
+
+        double get_surrogate_capacity(const std::vector<int64_t> &remaining) const {
+            double surrogate = 0.0;
+            for (int d=0; d<int(remaining.size()); ++d) if (problem_.capacities_[d] > 0) surrogate += remaining[d] / double(problem_.capacities_[d]);
+            return surrogate;
+        }
+
+        const KnapsackProblem &problem_;
+        std::vector<int> order_;
+        std::vector<double> surrogate_weights_, weight_prefix_;
+        std::vector<int64_t> value_prefix_;
+    };
+
+    //! Greedy or branch-and-bound for multi-constraint problems.
+    void solve_multi_search(const KnapsackProblem &problem, const KnapsackOptions &options, const bool greedy_only,
+                            KnapsackSolution &solution) {
+        const SurrogateOrderedObjects objects(problem);
+        const int n = int(objects.order_.size());
+        std::vector<int64_t> remaining(problem.capacities_.begin(), problem.capacities_.end());
+
+        solution.stats_.upper_bound_ = objects.calc_upper_bound(0, objects.get_surrogate_capacity(remaining));
+
+        std::vector<int> best_taken;
+        int64_t best_value = 0;
+        for (int j=0; j<n; ++j) {
+            if (objects.fits(j, remaining)) {
+                objects.add(j, remaining, 1);
+                best_taken.push_back(j);
+                best_value += problem.values_[objects.order_[j]];
+            }
+        }
+
+        bool completed = false;
+        uint64_t nodes = 0;
+
+        if (!greedy_only) { // Same DFS as knapsack_branch_and_bound, with all constraints checked.
+            remaining.assign(problem.capacities_.begin(), problem.capacities_.end());
+            std::vector<int> taken;
+            int64_t value = 0;
+            int j = 0;
+            completed = true;
+
+            while (true) {
+                bool backtrack = false;
+                if (++nodes > options.max_nodes_) {completed = false; nodes = options.max_nodes_; break;}
+
+                if ((j == n) || (value + objects.calc_upper_bound(j, objects.get_surrogate_capacity(remaining)) <= best_value)) {
+                    if (value > best_value) {best_value = value; best_taken = taken;}
+                    backtrack = true;
+                } else {
+                    while ((j < n) && objects.fits(j, remaining)) {
+                        taken.push_back(j);
+                        value += problem.values_[objects.order_[j]];
+                        objects.add(j, remaining, 1);
+                        ++j;
+                    }
+                    if (j < n) ++j;
+                    else {
+                        if (value > best_value) {best_value = value; best_taken = taken;}
+                        backtrack = true;
+                    }
+                }
+
+                if (backtrack) {
+                    if (taken.empty()) break;
+                    const int k = taken.back();
+                    taken.pop_back();
+                    value -= problem.values_[objects.order_[k]];
+                    objects.add(k, remaining, -1);
+                    j = k + 1;
+                }
+            }
+        }
+
+        for (const int j : best_taken) solution.counts_[objects.order_[j]] = 1;
+        solution.stats_.method_ = greedy_only ? KnapsackMethod::greedy : KnapsackMethod::branch_and_bound;
+        solution.stats_.is_optimal_ = completed;
+        solution.stats_.num_nodes_ = nodes;
+        solution.stats_.memory_bytes_ = size_t(problem.get_num_objects()) * (sizeof(int) + 3 * sizeof(double) + 2 * sizeof(int64_t));
+    }
+
+    //! Number of cells in the flattened capacity grid of a multi-constraint problem (saturates at 2^62).
+    uint64_t get_multi_num_cells(const KnapsackProblem &problem) {
+        uint64_t num_cells = 1;
+        for (const int capacity : problem.capacities_) {
+            num_cells *= uint64_t(capacity) + 1;
+            if (num_cells > (uint64_t(1) << 62)) return uint64_t(1) << 62;
+        }
+        return num_cells;
+    }
+
+    //! DP over the flattened capacity grid with a bit packed decision matrix.
+    void solve_multi_dyn_prog(const KnapsackProblem &problem, KnapsackSolution &solution) {
+        const int n = problem.get_num_objects();
+        const int m = problem.get_num_constraints();
+        const size_t num_cells = get_multi_num_cells(problem);
+        const size_t words_per_row = (num_cells + 63) / 64;
+
+        std::vector<size_t> strides(m, 1);
+        for (int d=1; d<m; ++d) strides[d] = strides[d - 1] * (size_t(problem.capacities_[d - 1]) + 1);
+
+        std::vector<int64_t> row(num_cells, 0);
+        std::vector<uint64_t> decisions(size_t(n) * words_per_row, 0);
+        std::vector<int> coords(m);
+
+        for (int i=0; i<n; ++i) {
+            if (problem.values_[i] <= 0) continue;
+            size_t offset = 0;
+            bool can_fit = true;
+            for (int d=0; d<m; ++d) {
+                can_fit = can_fit && (problem.weights_[d][i] <= problem.capacities_[d]);
+                offset += size_t(problem.weights_[d][i]) * strides[d];
+            }
+            if (!can_fit) continue;
+
+            uint64_t * const decision_row = &decisions[size_t(i) * words_per_row];
+            for (int d=0; d<m; ++d) coords[d] = problem.capacities_[d];
+
+            for (size_t c=num_cells; c-- > 0; ) { //Descending, with the coordinates of c kept in coords.
+                bool fits = true;
+                for (int d=0; d<m; ++d) fits = fits && (coords[d] >= problem.weights_[d][i]);
+
+                if (fits && (row[c - offset] + problem.values_[i] > row[c])) {
+                    row[c] = row[c - offset] + problem.values_[i];
+                    decision_row[c >> 6] |= uint64_t(1) << (c & 63);
+                }
+
+                for (int d=0; d<m; ++d) { //Decrement the mixed radix coordinates.
+                    if (coords[d] > 0) {--coords[d]; break;}
+                    coords[d] = problem.capacities_[d];
+                }
+            }
+        }
+
+        size_t c = num_cells - 1;
+        for (int i=n-1; i >= 0; --i) {
+            if ((decisions[size_t(i) * words_per_row + (c >> 6)] >> (c & 63)) & 1) {
+                solution.counts_[i] = 1;
+                for (int d=0; d<m; ++d) c -= size_t(problem.weights_[d][i]) * strides[d];
+            }
+        }
+
+        solution.stats_.method_ = KnapsackMethod::dyn_prog;
+        solution.stats_.is_optimal_ = true;
+        solution.stats_.memory_bytes_ = num_cells * sizeof(int64_t) + decisions.size() * sizeof(uint64_t);
+    }
+
+    //! Solve any of the knapsack kinds. See the notes at the top of the file for the automatic method choice.
+    KnapsackSolution solve_knapsack(const KnapsackProblem &problem, const KnapsackOptions &options = KnapsackOptions()) {
+        const double start_time = TCTimer::get_time();
+        const int n = problem.get_num_objects();
+        KnapsackSolution solution;
+        solution.counts_.assign(n, 0);
+
+        //Like the individual solvers, a negative capacity gives the empty solution (the DPs can't size their rows).
+        const bool has_negative_capacity = std::any_of(problem.capacities_.begin(), problem.capacities_.end(),
+                                                       [](const int W) {return W < 0;});
+
+        if ((n > 0) && (problem.get_num_constraints() > 0) && !has_negative_capacity) {
+            switch (problem.kind_) {
+                case KnapsackKind::zero_one:
+                    solve_bounded(problem, std::vector<int>(n, 1), options, solution);
+                    break;
+
+                case KnapsackKind::bounded:
+                    solve_bounded(problem, problem.counts_, options, solution);
+                    break;
+
+                case KnapsackKind::unbounded: {
+                    const uint64_t num_cells = uint64_t(n) * (uint64_t(problem.capacities_[0]) + 1);
+                    const bool use_dyn_prog = (options.method_ == KnapsackMethod::dyn_prog) ||
+                                              ((options.method_ == KnapsackMethod::automatic) && (num_cells <= options.small_dp_cells_));
+                    std::vector<int> counts(n, 0); //As bounded: as many copies as fit.
+                    for (int i=0; i<n; ++i) if (problem.weights_[0][i] > 0) counts[i] = problem.capacities_[0] / problem.weights_[0][i];
+
+                    if (use_dyn_prog) {
+                        WeightValueVect split_weight_value_vect;
+                        std::vector<SplitObject> split_objects;
+                        split_counts(problem, counts, split_weight_value_vect, split_objects);
+                        solution.stats_.upper_bound_ = fractional_upper_bound(split_weight_value_vect, problem.capacities_[0]);
+                        solve_unbounded_dyn_prog(problem, solution);
+                    } else {
+                        solve_bounded(problem, counts, options, solution);
+                    }
+                    break;
+                }
+
+                case KnapsackKind::multi_constraint: {
+                    const uint64_t num_cells = get_multi_num_cells(problem);
+                    const uint64_t dp_work = (num_cells > (uint64_t(1) << 62) / uint64_t(n)) ? (uint64_t(1) << 62) : num_cells * n;
+
+                    if ((options.method_ == KnapsackMethod::dyn_prog) ||
+                        ((options.method_ == KnapsackMethod::automatic) && (dp_work <= options.small_dp_cells_))) {
+                        solve_multi_search(problem, options, true, solution); //For the upper bound.
+                        std::fill(solution.counts_.begin(), solution.counts_.end(), 0);
+                        solve_multi_dyn_prog(problem, solution);
+                    } else {
+                        solve_multi_search(problem, options, options.method_ == KnapsackMethod::greedy, solution);
+                        if (!solution.stats_.is_optimal_ && (options.method_ == KnapsackMethod::automatic) && (dp_work <= options.max_dp_cells_)) {
+                            std::fill(solution.counts_.begin(), solution.counts_.end(), 0);
+                            solve_multi_dyn_prog(problem, solution);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+
+        for (int i=0; i<n; ++i) solution.value_ += int64_t(solution.counts_[i]) * problem.values_[i];
+        solution.stats_.solve_time_ = TCTimer::get_time() - start_time;
+        return solution;
+    }
+}
+
+#endif //TC_KNAPSACK_H
@@ -0,0 +1,191 @@
+#ifndef TC_KNAPSACK_BRANCH_BOUND_H
+#define TC_KNAPSACK_BRANCH_BOUND_H 1
+
+#include "../defines/tc_defines.h"
+#include "tc_knapsack_dyn_prog.h"
+
+#include <vector>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+//=========================================//
+//=== TC Knapsack Greedy & Branch-Bound ===//
+//=========================================//
+/*!
+ * Knapsack solvers that don't depend on the capacity W, built on one sort of the objects by value density:
+ * - knapsack_greedy_sorted takes the objects in order of decreasing value/weight if they still fit. Same result as
+ *   the O(n^2) knapsack_greedy in main.cpp, in O(n log n).
+ * - fractional_upper_bound is the LP (Dantzig) bound: whole objects in density order plus a fraction of the first
+ *   one that doesn't fit.
+ * - knapsack_branch_and_bound is a depth-first (Horowitz-Sahni style) search over the sorted objects that takes an
+ *   object whenever it fits, starts from the greedy solution and prunes every node whose fractional bound can't
+ *   beat the best solution. The bound is O(log n) per node with prefix sums. max_nodes limits the search; if it
+ *   is reached the best solution found so far is returned and *is_optimal is set to false.
+ * Densities are compared as value_a * weight_b > value_b * weight_a in int64_t, so no floating point ties.
+ * EXAMPLE Usage:
+ *   bool is_optimal = false;
+ *   const std::vector<int> object_ids = tc_knapsack::knapsack_branch_and_bound(weight_value_vect, W, 100000000, &is_optimal);
+ */
+
+namespace tc_knapsack {
+    /*!
+     * Ids of the objects with a value > 0 (the others never help), zero weight objects first and then by decreasing
+     * value/weight, ties by id. With positive values and weights the cross multiplied compare is a strict weak
+     * ordering; a zero weight or zero value object would compare equal to every other object.
+     */
+    std::vector<int> sort_by_value_density(const WeightValueVect &weight_value_vect_) {
+        std::vector<int> order;
+        order.reserve(weight_value_vect_.size());
+        for (int id=0; id<int(weight_value_vect_.size()); ++id) {
+            if (weight_value_vect_[id].second > 0) order.push_back(id);
+        }
+
+        std::sort(order.begin(), order.end(), [&weight_value_vect_](const int a, const int b) {
+            const bool a_is_free = weight_value_vect_[a].first == 0;
+            const bool b_is_free = weight_value_vect_[b].first == 0;
+            if (a_is_free || b_is_free) return (a_is_free != b_is_free) ? a_is_free : (a < b);
+
+            const int64_t lhs = int64_t(weight_value_vect_[a].second) * weight_value_vect_[b].first;
+            const int64_t rhs = int64_t(weight_value_vect_[b].second) * weight_value_vect_[a].first;
+            return (lhs > rhs) || ((lhs == rhs) && (a < b));
+        });
+        return order;
+    }
+
+    //! Greedy by value density with a single sort. Returns sorted object ids.
+    std::vector<int> knapsack_greedy_sorted(const WeightValueVect &weight_value_vect_, const int W_) {
+        std::vector<int> object_ids;
+        int64_t remaining_W = W_;
+
+        for (const int id : sort_by_value_density(weight_value_vect_)) {
+            if (weight_value_vect_[id].first <= remaining_W) {
+                object_ids.push_back(id);
+                remaining_W -= weight_value_vect_[id].first;
+            }
+        }
+
+        std::sort(object_ids.begin(), object_ids.end());
+        return object_ids;
+    }
+
+    //! Objects in density order with prefix sums, for O(log n) fractional bounds of any suffix.
+    class DensityOrderedObjects {
+    public:
+        explicit DensityOrderedObjects(const WeightValueVect &weight_value_vect_) :
+        order_(sort_by_value_density(weight_value_vect_)),
+        weights_(order_.size()), values_(order_.size()),
+        weight_prefix_(order_.size() + 1, 0), value_prefix_(order_.size() + 1, 0) {
+            for (size_t j=0; j<order_.size(); ++j) {
+                weights_[j] = weight_value_vect_[order_[j]].first;
+                values_[j] = weight_value_vect_[order_[j]].second;
+                weight_prefix_[j + 1] = weight_prefix_[j] + weights_[j];
+                value_prefix_[j + 1] = value_prefix_[j] + values_[j];
+            }
+        }
+
+        /*!
+         * Fractional (LP) bound on the value that objects [j, n) can add with capacity remaining_W: the whole objects
+         * up to the critical one (the first that doesn't fit) plus the fitting fraction of it, rounded down.
+         */
+        ALWAYS_INLINE int64_t calc_upper_bound(const int j, const int64_t remaining_W) const {
+            const int n = int(order_.size());
+            const int64_t weight_limit = weight_prefix_[j] + remaining_W;
+            const int r = int(std::upper_bound(weight_prefix_.begin() + j + 1, weight_prefix_.end(), weight_limit) - weight_prefix_.begin()) - 1;
+            int64_t bound = value_prefix_[r] - value_prefix_[j];
+            if (r < n) bound += (weight_limit - weight_prefix_[r]) * values_[r] / weights_[r];
+            return bound;
+        }
+
+        int size() const noexcept {return int(order_.size());}
+
+        std::vector<int> order_;              //!< Object id of each position.
+        std::vector<int64_t> weights_, values_; //!< By position.
+        std::vector<int64_t> weight_prefix_, value_prefix_;
+    };
+
+    //! The LP relaxation bound on the knapsack value.
+    int64_t fractional_upper_bound(const WeightValueVect &weight_value_vect_, const int W_) {
+        return DensityOrderedObjects(weight_value_vect_).calc_upper_bound(0, W_);
+    }
+
+    /*!
+     * Exact depth-first branch-and-bound with fractional bounds. Returns sorted object ids. If max_nodes is reached
+     * the best solution found is returned and *is_optimal (if given) is false. *num_nodes (if given) is the number of
+     * nodes visited.
+     */
+    std::vector<int> knapsack_branch_and_bound(const WeightValueVect &weight_value_vect_, const int W_,
+                                               const uint64_t max_nodes = 100000000,
+                                               bool * const is_optimal = nullptr, uint64_t * const num_nodes = nullptr) {
+        const DensityOrderedObjects objects(weight_value_vect_);
+        const int n = objects.size();
+
+        // The greedy solution is the first lower bound.
+        std::vector<int> best_taken; //Positions in density order.
+        int64_t best_value = 0;
+        {
+            int64_t remaining_W = W_;
+            for (int j=0; j<n; ++j) {
+                if (objects.weights_[j] <= remaining_W) {
+                    best_taken.push_back(j);
+                    best_value += objects.values_[j];
+                    remaining_W -= objects.weights_[j];
+                }
+            }
+        }
+
+        // DFS: go forward taking every object that fits; the taken positions are the open branch points. Backtracking
+        // un-takes the last taken object and continues with it skipped.
+        std::vector<int> taken;
+        int64_t value = 0, remaining_W = W_;
+        int j = 0;
+        uint64_t nodes = 0;
+        bool completed = true;
+
+        while (true) {
+            bool backtrack = false;
+
+            if (++nodes > max_nodes) {completed = false; break;}
+
+            if ((j == n) || (value + objects.calc_upper_bound(j, remaining_W) <= best_value)) {
+                if (value > best_value) {best_value = value; best_taken = taken;}
+                backtrack = true;
+            } else {
+                // Forward: take objects while they fit, skip those that don't.
+                while ((j < n) && (objects.weights_[j] <= remaining_W)) {
+                    taken.push_back(j);
+                    value += objects.values_[j];
+                    remaining_W -= objects.weights_[j];
+                    ++j;
+                }
+                if (j < n) ++j; //Object j doesn't fit.
+                else {
+                    if (value > best_value) {best_value = value; best_taken = taken;}
+                    backtrack = true;
+                }
+            }
+
+            if (backtrack) {
+                if (taken.empty()) break;
+                const int k = taken.back();
+                taken.pop_back();
+                value -= objects.values_[k];
+                remaining_W += objects.weights_[k];
+                j = k + 1;
+            }
+        }
+
+        if (is_optimal != nullptr) *is_optimal = completed;
+        if (num_nodes != nullptr) *num_nodes = std::min(nodes, max_nodes);
+
+        std::vector<int> object_ids;
+        object_ids.reserve(best_taken.size());
+        for (const int position : best_taken) object_ids.push_back(objects.order_[position]);
+        std::sort(object_ids.begin(), object_ids.end());
+        return object_ids;
+    }
+}
+
+#endif //TC_KNAPSACK_BRANCH_BOUND_H
@@ -0,0 +1,171 @@
+#ifndef TC_KNAPSACK_DYN_PROG_H
+#define TC_KNAPSACK_DYN_PROG_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+//===================================//
+//=== TC Knapsack Dynamic Prog ======//
+//===================================//
+/*!
+ * Space optimised 0/1 knapsack DP solvers. Objects are (weight, value) pairs as in main.cpp. Both solvers keep a
+ * single rolling row of W+1 values instead of the full (n+1) x (W+1) int64_t table:
+ * - knapsack_dyn_prog_hirschberg recovers the chosen objects by divide and conquer: the best value of the first half
+ *   of the objects for every capacity is combined with that of the second half to find how the capacity is split,
+ *   and each half is solved again with its share. O(W) memory (+ recursion depth log n), about 2x the DP work.
+ * - knapsack_dyn_prog_bit_matrix keeps one decision bit per cell (object i improved capacity w) and traces the
+ *   solution back through the bits. n*(W+1)/8 bytes, 64x less than the int64_t table, and the DP work only once.
+ * knapsack_dyn_prog_table is the full table baseline (the DP of main.cpp without printing the table), for comparison.
+ * EXAMPLE Usage:
+ *   std::vector<std::pair<int, int>> weight_value_vect = {{3, 8}, {4, 12}, {2, 5}};
+ *   const std::vector<int> object_ids = tc_knapsack::knapsack_dyn_prog_hirschberg(weight_value_vect, 5); // {0, 2}
+ */
+
+namespace tc_knapsack {
+    typedef std::vector<std::pair<int, int>> WeightValueVect;
+
+    //! row[w] = max(row[w], row[w - weight] + value) for w >= weight; w descends so that each object is used once.
+    ALWAYS_INLINE void update_row(int64_t * const row, const int W_, const int object_weight, const int64_t object_value) {
+        for (int w=W_; w >= object_weight; --w) {
+            row[w] = std::max(row[w], row[w - object_weight] + object_value);
+        }
+    }
+
+    //! row[w] = best value of objects [first, last) with total weight <= w.
+    void calc_dyn_prog_row(const WeightValueVect &weight_value_vect_, const int first, const int last,
+                           const int W_, std::vector<int64_t> &row) {
+        row.assign(W_ + 1, 0);
+        for (int i=first; i<last; ++i) update_row(row.data(), W_, weight_value_vect_[i].first, weight_value_vect_[i].second);
+    }
+
+    /*!
+     * Append the objects of [first, last) that make up a best solution for capacity W_ to object_ids.
+     * calc_row(first, last, W, row) must fill row with the best values of objects [first, last) for capacities 0..W.
+     */
+    template<class Cell, class CalcRow>
+    void hirschberg_solve(const WeightValueVect &weight_value_vect_, const int first, const int last, const int W_,
+                          std::vector<Cell> &row_a, std::vector<Cell> &row_b, std::vector<int> &object_ids,
+                          CalcRow &calc_row) {
+        if (last - first == 1) {
+            if ((weight_value_vect_[first].first <= W_) && (weight_value_vect_[first].second > 0)) object_ids.push_back(first);
+            return;
+        }
+
+        const int mid = first + (last - first) / 2;
+        int W_first = 0; // The capacity that goes to [first, mid).
+
+        {// Split the capacity where (best of first half at c) + (best of second half at W-c) is largest.
+            calc_row(first, mid, W_, row_a);
+            calc_row(mid, last, W_, row_b);
+
+            int64_t best_value = -1;
+            for (int c=0; c <= W_; ++c) {
+                const int64_t value = int64_t(row_a[c]) + row_b[W_ - c];
+                if (value > best_value) {best_value = value; W_first = c;}
+            }
+        }
+
+        hirschberg_solve(weight_value_vect_, first, mid, W_first, row_a, row_b, object_ids, calc_row);
+        hirschberg_solve(weight_value_vect_, mid, last, W_ - W_first, row_a, row_b, object_ids, calc_row);
+    }
+
+    //! Solve the knapsack problem with one rolling DP row and Hirschberg reconstruction. Returns sorted object ids.
+    std::vector<int> knapsack_dyn_prog_hirschberg(const WeightValueVect &weight_value_vect_, const int W_) {
+        std::vector<int> object_ids;
+        if (weight_value_vect_.empty() || (W_ < 0)) return object_ids;
+
+        std::vector<int64_t> row_a, row_b; //Reused at every level, so only two rows of W_+1 are ever allocated.
+        row_a.reserve(W_ + 1);
+        row_b.reserve(W_ + 1);
+        auto calc_row = [&weight_value_vect_](const int first, const int last, const int W, std::vector<int64_t> &row) {
+            calc_dyn_prog_row(weight_value_vect_, first, last, W, row);
+        };
+        hirschberg_solve(weight_value_vect_, 0, int(weight_value_vect_.size()), W_, row_a, row_b, object_ids, calc_row);
+        return object_ids;
+    }
+
+    //! Bytes used by knapsack_dyn_prog_hirschberg (the two rows).
+    size_t get_hirschberg_memory_usage(const int n, const int W_) {(void)n; return 2 * size_t(W_ + 1) * sizeof(int64_t);}
+
+    //! Solve the knapsack problem with one rolling DP row and a bit packed decision matrix. Returns sorted object ids.
+    std::vector<int> knapsack_dyn_prog_bit_matrix(const WeightValueVect &weight_value_vect_, const int W_) {
+        const int n = int(weight_value_vect_.size());
+        std::vector<int> object_ids;
+        if ((n == 0) || (W_ < 0)) return object_ids;
+
+        const size_t words_per_row = (size_t(W_) + 1 + 63) / 64;
+        std::vector<uint64_t> decisions(n * words_per_row, 0); //Bit w of row i: object i improved capacity w.
+        std::vector<int64_t> row(W_ + 1, 0);
+
+        for (int i=0; i<n; ++i) {
+            const int object_weight = weight_value_vect_[i].first;
+            const int64_t object_value = weight_value_vect_[i].second;
+            uint64_t * const decision_row = &decisions[i * words_per_row];
+
+            for (int w=W_; w >= object_weight; --w) {
+                const int64_t value_with = row[w - object_weight] + object_value;
+                const bool take = value_with > row[w];
+                row[w] = take ? value_with : row[w];
+                decision_row[w >> 6] |= uint64_t(take) << (w & 63);
+            }
+        }
+
+        int w = W_;
+        for (int i=n-1; i >= 0; --i) {
+            if ((decisions[i * words_per_row + (w >> 6)] >> (w & 63)) & 1) {
+                object_ids.push_back(i);
+                w -= weight_value_vect_[i].first;
+            }
+        }
+
+        std::reverse(object_ids.begin(), object_ids.end());
+        return object_ids;
+    }
+
+    //! Solve the knapsack problem with the full (n+1) x (W+1) value table. Returns sorted object ids.
+    std::vector<int> knapsack_dyn_prog_table(const WeightValueVect &weight_value_vect_, const int W_) {
+        const int n = int(weight_value_vect_.size());
+        std::vector<int> object_ids;
+        if ((n == 0) || (W_ < 0)) return object_ids;
+
+        const size_t row_size = size_t(W_) + 1;
+        std::vector<int64_t> table((size_t(n) + 1) * row_size, 0);
+
+        for (int i=1; i <= n; ++i) {
+            const int object_weight = weight_value_vect_[i-1].first;
+            const int64_t object_value = weight_value_vect_[i-1].second;
+            const int64_t * const prev_row = &table[(i - 1) * row_size];
+            int64_t * const row = &table[i * row_size];
+
+            for (int w=0; w <= W_; ++w) {
+                row[w] = (object_weight > w) ? prev_row[w] : std::max(prev_row[w], prev_row[w - object_weight] + object_value);
+            }
+        }
+
+        int w = W_;
+        for (int i=n; i > 0; --i) {
+            if (table[i * row_size + w] != table[(i - 1) * row_size + w]) {
+                object_ids.push_back(i - 1);
+                w -= weight_value_vect_[i-1].first;
+            }
+        }
+
+        std::reverse(object_ids.begin(), object_ids.end());
+        return object_ids;
+    }
+
+    //! Bytes used by knapsack_dyn_prog_table.
+    size_t get_table_memory_usage(const int n, const int W_) {return (size_t(n) + 1) * (size_t(W_) + 1) * sizeof(int64_t);}
+
+    //! Bytes used by knapsack_dyn_prog_bit_matrix (the decision bits and the row).
+    size_t get_bit_matrix_memory_usage(const int n, const int W_) {
+        return size_t(n) * ((size_t(W_) + 1 + 63) / 64) * sizeof(uint64_t) + size_t(W_ + 1) * sizeof(int64_t);
+    }
+}
+
+#endif //TC_KNAPSACK_DYN_PROG_H
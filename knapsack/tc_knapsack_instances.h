@@ -0,0 +1,75 @@
+#ifndef TC_KNAPSACK_INSTANCES_H
+#define TC_KNAPSACK_INSTANCES_H 1
+
+#include "../defines/tc_defines.h"
+#include "../random/tc_random_funcs.h"
+#include "tc_knapsack_dyn_prog.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+//===============================//
+//=== TC Knapsack Instances =====//
+//===============================//
+/*!
+ * Random 0/1 knapsack instances in the standard classes of Pisinger ("Where are the hard knapsack problems?", 2005).
+ * Weights are uniform in [1, R]. The values depend on the class:
+ * - uncorrelated: uniform in [1, R]. Easy for branch-and-bound, because the densities differ a lot.
+ * - weakly_correlated: uniform in [w - R/10, w + R/10], at least 1.
+ * - strongly_correlated: w + R/10. Hard for branch-and-bound, because every object has almost the same density.
+ * - subset_sum: w. Fill the knapsack as full as possible.
+ * The capacity is capacity_fraction of the total weight, so W grows as n*R*capacity_fraction/2.
+ * EXAMPLE Usage:
+ *   TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321);
+ *   tc_knapsack::WeightValueVect weight_value_vect;
+ *   const int W = tc_knapsack::make_knapsack_instance(rng, tc_knapsack::InstanceClass::strongly_correlated, 1000, 10000,
+ *                                                     0.5, weight_value_vect);
+ */
+
+namespace tc_knapsack {
+    enum class InstanceClass {uncorrelated, weakly_correlated, strongly_correlated, subset_sum};
+
+    const char *get_instance_class_name(const InstanceClass instance_class) {
+        switch (instance_class) {
+            case InstanceClass::uncorrelated: return "uncorrelated";
+            case InstanceClass::weakly_correlated: return "weakly_correlated";
+            case InstanceClass::strongly_correlated: return "strongly_correlated";
+            case InstanceClass::subset_sum: return "subset_sum";
+        }
+        return "?";
+    }
+
+    /*!
+     * Fill weight_value_vect_ with n objects of the class, weights in [1, R_]. Returns the capacity W (at least 1).
+     * n * R_ must fit in an int.
+     */
+    template<class RandFunc>
+    int make_knapsack_instance(TCRandom<RandFunc> &rng, const InstanceClass instance_class, const int n, const int R_,
+                               const double capacity_fraction, WeightValueVect &weight_value_vect_) {
+        weight_value_vect_.clear();
+        weight_value_vect_.reserve(n);
+        const int R_10 = std::max(R_ / 10, 1);
+        int64_t weight_sum = 0;
+
+        for (int i=0; i<n; ++i) {
+            const int weight = int(rng.next(1, R_ + 1));
+            int value = weight;
+
+            switch (instance_class) {
+                case InstanceClass::uncorrelated: value = int(rng.next(1, R_ + 1)); break;
+                case InstanceClass::weakly_correlated: value = std::max(weight - R_10 + int(rng.next(2 * R_10 + 1)), 1); break;
+                case InstanceClass::strongly_correlated: value = weight + R_10; break;
+                case InstanceClass::subset_sum: break;
+            }
+
+            weight_value_vect_.push_back(std::make_pair(weight, value));
+            weight_sum += weight;
+        }
+
+        return std::max(int(weight_sum * capacity_fraction), 1);
+    }
+}
+
+#endif //TC_KNAPSACK_INSTANCES_H
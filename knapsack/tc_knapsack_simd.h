@@ -0,0 +1,270 @@
+#ifndef TC_KNAPSACK_SIMD_H
+#define TC_KNAPSACK_SIMD_H 1
+
+#include "../defines/tc_defines.h"
+#include "tc_knapsack_dyn_prog.h"
+
+#include <immintrin.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+//===================================//
+//=== TC Knapsack SIMD Row Engine ===//
+//===================================//
+/*!
+ * Vectorised and multithreaded knapsack DP row update: cur[w] = max(prev[w], prev[w - weight] + value).
+ * - Two rows are swapped per object so that each cell only reads the previous row; there is no branch on
+ *   weight > w, the cells below the weight are copied.
+ * - Cell is int32_t (8 cells per AVX2 vector) when the sum of all values fits, otherwise int64_t (4 cells; AVX2 has
+ *   no max_epi64, so cmpgt_epi64 + blendv is used unless AVX-512VL is available). Without AVX2 (compile with -mavx2)
+ *   the scalar loop remains.
+ * - TCKnapsackRowEngine keeps num_threads-1 worker threads. Each thread owns the same contiguous block of every row
+ *   (at least min_cells_per_thread_, so that a block stays in the thread's cache) and the threads meet at a spin
+ *   barrier after each object. Rows that are too short for more than one block run on the calling thread. Between
+ *   jobs the workers spin briefly (Hirschberg sends many jobs in a row) and then sleep on a condition variable, so a
+ *   kept engine doesn't use CPU while idle.
+ * - knapsack_dyn_prog_simd reconstructs the chosen objects with Hirschberg (see tc_knapsack_dyn_prog.h) on top of
+ *   the engine, so it also only needs two rows.
+ * EXAMPLE Usage:
+ *   const std::vector<int> object_ids = tc_knapsack::knapsack_dyn_prog_simd(weight_value_vect, W); //All hardware threads.
+ *
+ *   tc_knapsack::TCKnapsackRowEngine<int32_t> engine(4);  //Reuse the threads for many instances.
+ *   std::vector<int32_t> row;
+ *   engine.calc_row(weight_value_vect, 0, weight_value_vect.size(), W, row); //row[W] is the best value.
+ */
+
+namespace tc_knapsack {
+    //! cur[w] = max(prev[w], prev[w - object_weight] + object_value) for w in [w_begin, w_end), prev[w] below the weight.
+    template<class Cell>
+    ALWAYS_INLINE void update_row_block(const Cell * const prev, Cell * const cur, const int w_begin, const int w_end,
+                                        const int object_weight, const Cell object_value) {
+        int w = w_begin;
+        const int copy_end = std::min(w_end, std::max(w_begin, object_weight));
+        if (copy_end > w) std::memcpy(cur + w, prev + w, (copy_end - w) * sizeof(Cell));
+        w = copy_end;
+
+        for (; w < w_end; ++w) cur[w] = std::max(prev[w], Cell(prev[w - object_weight] + object_value));
+    }
+
+#if defined(__AVX2__)
+    template<>
+    ALWAYS_INLINE void update_row_block<int32_t>(const int32_t * const prev, int32_t * const cur, const int w_begin, const int w_end,
+                                                 const int object_weight, const int32_t object_value) {
+        int w = w_begin;
+        const int copy_end = std::min(w_end, std::max(w_begin, object_weight));
+        if (copy_end > w) std::memcpy(cur + w, prev + w, (copy_end - w) * sizeof(int32_t));
+        w = copy_end;
+
+        const __m256i value = _mm256_set1_epi32(object_value);
+        for (; w + 8 <= w_end; w += 8) {
+            const __m256i without = _mm256_loadu_si256((const __m256i *) (prev + w));
+            const __m256i with = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (prev + w - object_weight)), value);
+            _mm256_storeu_si256((__m256i *) (cur + w), _mm256_max_epi32(without, with));
+        }
+
+        for (; w < w_end; ++w) cur[w] = std::max(prev[w], prev[w - object_weight] + object_value);
+    }
+
+    template<>
+    ALWAYS_INLINE void update_row_block<int64_t>(const int64_t * const prev, int64_t * const cur, const int w_begin, const int w_end,
+                                                 const int object_weight, const int64_t object_value) {
+        int w = w_begin;
+        const int copy_end = std::min(w_end, std::max(w_begin, object_weight));
+        if (copy_end > w) std::memcpy(cur + w, prev + w, (copy_end - w) * sizeof(int64_t));
+        w = copy_end;
+
+        const __m256i value = _mm256_set1_epi64x(object_value);
+        for (; w + 4 <= w_end; w += 4) {
+            const __m256i without = _mm256_loadu_si256((const __m256i *) (prev + w));
+            const __m256i with = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *) (prev + w - object_weight)), value);
+#if defined(__AVX512VL__)
+            _mm256_storeu_si256((__m256i *) (cur + w), _mm256_max_epi64(without, with));
+#else
+            _mm256_storeu_si256((__m256i *) (cur + w), _mm256_blendv_epi8(without, with, _mm256_cmpgt_epi64(with, without)));
+#endif
+        }
+
+        for (; w < w_end; ++w) cur[w] = std::max(prev[w], prev[w - object_weight] + object_value);
+    }
+#endif
+
+    //! Computes DP rows with SIMD and a fixed team of threads. Not thread safe; use one engine per calling thread.
+    template<class Cell>
+    class TCKnapsackRowEngine {
+    public:
+        static constexpr int min_cells_per_thread_ = 16384; //!< 64KB (int32) or 128KB (int64) per block.
+        static constexpr int idle_spins_ = 1024; //!< Yields before an idle worker sleeps.
+
+        explicit TCKnapsackRowEngine(int num_threads = 0) {
+            if (num_threads <= 0) num_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+            num_threads_ = num_threads;
+            for (int t=1; t<num_threads_; ++t) workers_.emplace_back(&TCKnapsackRowEngine::worker_loop, this, t);
+        }
+
+        ~TCKnapsackRowEngine() {
+            stop_.store(true, std::memory_order_release);
+            start_job();
+            for (auto &worker : workers_) worker.join();
+        }
+
+        TCKnapsackRowEngine(const TCKnapsackRowEngine &) = delete;
+        TCKnapsackRowEngine &operator=(const TCKnapsackRowEngine &) = delete;
+
+        int get_num_threads() const noexcept {return num_threads_;}
+
+        //! row[w] = best value of objects [first, last) with total weight <= w, for w in [0, W_].
+        void calc_row(const WeightValueVect &weight_value_vect_, const int first, const int last, const int W_,
+                      std::vector<Cell> &row) {
+            row.assign(W_ + 1, 0);
+            other_row_.resize(W_ + 1);
+            if (first >= last) return;
+
+            job_objects_ = &weight_value_vect_;
+            job_first_ = first;
+            job_last_ = last;
+            job_W_ = W_;
+            rows_[0] = row.data();
+            rows_[1] = other_row_.data();
+            job_num_threads_ = int(std::min<size_t>(num_threads_, std::max<size_t>((W_ + 1) / min_cells_per_thread_, 1)));
+
+            if (job_num_threads_ > 1) {
+                workers_done_.store(0, std::memory_order_relaxed);
+                start_job();
+            }
+
+            run_job(0);
+
+            if (job_num_threads_ > 1) {
+                while (workers_done_.load(std::memory_order_acquire) != (num_threads_ - 1)) std::this_thread::yield();
+            }
+
+            // After an odd number of objects the result is in the other row.
+            if ((last - first) & 1) row.swap(other_row_);
+        }
+
+    private:
+        //! Thread t's share of the current job: its block of every row, one object at a time.
+        void run_job(const int t) {
+            if (t < job_num_threads_) {
+                const int num_cells = job_W_ + 1;
+                const int w_begin = int(int64_t(num_cells) * t / job_num_threads_);
+                const int w_end = int(int64_t(num_cells) * (t + 1) / job_num_threads_);
+                int parity = 0;
+
+                for (int i=job_first_; i<job_last_; ++i) {
+                    const auto &object = (*job_objects_)[i];
+                    update_row_block<Cell>(rows_[parity], rows_[parity ^ 1], w_begin, w_end, object.first, Cell(object.second));
+                    parity ^= 1;
+                    if (job_num_threads_ > 1) barrier_wait();
+                }
+            }
+        }
+
+        //! New job generation; wakes the sleeping workers.
+        void start_job() {
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                job_generation_.fetch_add(1, std::memory_order_release);
+            }
+            idle_cv_.notify_all();
+        }
+
+        void worker_loop(const int t) {
+            uint64_t seen_generation = 0;
+
+            while (true) {
+                uint64_t generation = job_generation_.load(std::memory_order_acquire);
+                for (int spin=0; (generation == seen_generation) && (spin < idle_spins_); ++spin) {
+                    std::this_thread::yield();
+                    generation = job_generation_.load(std::memory_order_acquire);
+                }
+                if (generation == seen_generation) {
+                    std::unique_lock<std::mutex> lock(idle_mutex_);
+                    idle_cv_.wait(lock, [this, seen_generation]() {
+                        return job_generation_.load(std::memory_order_acquire) != seen_generation;
+                    });
+                    generation = job_generation_.load(std::memory_order_acquire);
+                }
+                seen_generation = generation;
+                if (stop_.load(std::memory_order_acquire)) return;
+
+                run_job(t);
+                workers_done_.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        //! Sense reversing barrier for the job_num_threads_ threads working on the rows.
+        void barrier_wait() {
+            const unsigned sense = barrier_sense_.load(std::memory_order_relaxed);
+            if (barrier_count_.fetch_add(1, std::memory_order_acq_rel) == (job_num_threads_ - 1)) {
+                barrier_count_.store(0, std::memory_order_relaxed);
+                barrier_sense_.store(sense ^ 1, std::memory_order_release);
+            } else {
+                while (barrier_sense_.load(std::memory_order_acquire) == sense) std::this_thread::yield();
+            }
+        }
+
+        int num_threads_ = 1;
+        std::vector<std::thread> workers_;
+        std::vector<Cell> other_row_;
+
+        const WeightValueVect *job_objects_ = nullptr;
+        int job_first_ = 0, job_last_ = 0, job_W_ = 0, job_num_threads_ = 1;
+        Cell *rows_[2] = {nullptr, nullptr};   //!< rows_[0] holds the values before the first object.
+
+        std::atomic<uint64_t> job_generation_{0};
+        std::mutex idle_mutex_;
+        std::condition_variable idle_cv_;
+        std::atomic<int> workers_done_{0};
+        std::atomic<bool> stop_{false};
+        std::atomic<int> barrier_count_{0};
+        std::atomic<unsigned> barrier_sense_{0};
+    };
+
+    template<class Cell> constexpr int TCKnapsackRowEngine<Cell>::min_cells_per_thread_;
+    template<class Cell> constexpr int TCKnapsackRowEngine<Cell>::idle_spins_;
+
+    //! Hirschberg reconstruction on the SIMD row engine.
+    template<class Cell>
+    std::vector<int> knapsack_dyn_prog_simd_impl(const WeightValueVect &weight_value_vect_, const int W_, const int num_threads) {
+        std::vector<int> object_ids;
+        TCKnapsackRowEngine<Cell> engine(num_threads);
+        std::vector<Cell> row_a, row_b;
+        row_a.reserve(W_ + 1);
+        row_b.reserve(W_ + 1);
+
+        auto calc_row = [&engine, &weight_value_vect_](const int first, const int last, const int W, std::vector<Cell> &row) {
+            engine.calc_row(weight_value_vect_, first, last, W, row);
+        };
+        hirschberg_solve(weight_value_vect_, 0, int(weight_value_vect_.size()), W_, row_a, row_b, object_ids, calc_row);
+        return object_ids;
+    }
+
+    //! True if every sum of values fits in an int32_t cell.
+    bool values_fit_int32(const WeightValueVect &weight_value_vect_) {
+        int64_t sum = 0;
+        for (const auto &object : weight_value_vect_) sum += std::max(object.second, 0);
+        return sum <= std::numeric_limits<int32_t>::max();
+    }
+
+    /*!
+     * Solve the knapsack problem with the SIMD/multithreaded row engine and Hirschberg reconstruction. Returns sorted
+     * object ids. num_threads=0 uses the hardware concurrency.
+     */
+    std::vector<int> knapsack_dyn_prog_simd(const WeightValueVect &weight_value_vect_, const int W_, const int num_threads = 0) {
+        if (weight_value_vect_.empty() || (W_ < 0)) return std::vector<int>();
+        return values_fit_int32(weight_value_vect_) ? knapsack_dyn_prog_simd_impl<int32_t>(weight_value_vect_, W_, num_threads) :
+                                                      knapsack_dyn_prog_simd_impl<int64_t>(weight_value_vect_, W_, num_threads);
+    }
+}
+
+#endif //TC_KNAPSACK_SIMD_H
@@ -1,3 +1,12 @@
+#ifndef TC_MIN_MAX_CLAMP_BETWEEN_H
+#define TC_MIN_MAX_CLAMP_BETWEEN_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+
 template<class T>
 inline const T& min(const T& a, const T& b)
 {
@@ -54,3 +63,191 @@ inline bool between(const T& a, const T& b, const T& c)
 {
     return (a >= b) && (a <= c);
 }
+
+
+//==============================//
+//=== Array kernels ============//
+//==============================//
+/*!
+ * Branchless array versions of clamp, min/max, argmin/argmax and between for int32_t, float and double. The AVX2
+ * compare/blend path is compiled in when the target supports it (e.g. -mavx2), otherwise only the scalar loop remains.
+ * The float versions assume NaN-free input, except clamp_array which passes NaNs through like clamp does.
+ */
+namespace min_max_simd {
+#if defined(__AVX2__)
+    template<typename T> struct SimdOps;
+
+    template<> struct SimdOps<int32_t> {
+        typedef __m256i V;
+        static constexpr int width = 8;
+        static ALWAYS_INLINE V load(const int32_t *p) noexcept {return _mm256_loadu_si256((const __m256i *) p);}
+        static ALWAYS_INLINE void store(int32_t *p, const V v) noexcept {_mm256_storeu_si256((__m256i *) p, v);}
+        static ALWAYS_INLINE V set1(const int32_t a) noexcept {return _mm256_set1_epi32(a);}
+        static ALWAYS_INLINE V min(const V a, const V b) noexcept {return _mm256_min_epi32(a, b);}
+        static ALWAYS_INLINE V max(const V a, const V b) noexcept {return _mm256_max_epi32(a, b);}
+        static ALWAYS_INLINE __m256i lt(const V a, const V b) noexcept {return _mm256_cmpgt_epi32(b, a);}
+        static ALWAYS_INLINE __m256i in_range(const V a, const V l, const V u) noexcept { // (a >= l) && (a <= u)
+            return _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(l, a), _mm256_cmpgt_epi32(a, u)), _mm256_set1_epi32(-1));
+        }
+        static ALWAYS_INLINE int count(const __m256i mask) noexcept {return __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));}
+        static ALWAYS_INLINE __m256i idx_first() noexcept {return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);}
+        static ALWAYS_INLINE __m256i idx_next(const __m256i idx) noexcept {return _mm256_add_epi32(idx, _mm256_set1_epi32(8));}
+        static ALWAYS_INLINE V blend(const V a, const V b, const __m256i mask) noexcept {return _mm256_blendv_epi8(a, b, mask);}
+        static ALWAYS_INLINE void store_idx(int64_t *p, const __m256i idx) noexcept {
+            int32_t t[8]; _mm256_storeu_si256((__m256i *) t, idx);
+            for (int i=0; i<8; ++i) p[i] = t[i];
+        }
+    };
+
+    template<> struct SimdOps<float> {
+        typedef __m256 V;
+        static constexpr int width = 8;
+        static ALWAYS_INLINE V load(const float *p) noexcept {return _mm256_loadu_ps(p);}
+        static ALWAYS_INLINE void store(float *p, const V v) noexcept {_mm256_storeu_ps(p, v);}
+        static ALWAYS_INLINE V set1(const float a) noexcept {return _mm256_set1_ps(a);}
+        static ALWAYS_INLINE V min(const V a, const V b) noexcept {return _mm256_min_ps(a, b);}
+        static ALWAYS_INLINE V max(const V a, const V b) noexcept {return _mm256_max_ps(a, b);}
+        static ALWAYS_INLINE __m256i lt(const V a, const V b) noexcept {return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ));}
+        static ALWAYS_INLINE __m256i in_range(const V a, const V l, const V u) noexcept {
+            return _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(a, l, _CMP_GE_OQ), _mm256_cmp_ps(a, u, _CMP_LE_OQ)));
+        }
+        static ALWAYS_INLINE int count(const __m256i mask) noexcept {return __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));}
+        static ALWAYS_INLINE __m256i idx_first() noexcept {return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);}
+        static ALWAYS_INLINE __m256i idx_next(const __m256i idx) noexcept {return _mm256_add_epi32(idx, _mm256_set1_epi32(8));}
+        static ALWAYS_INLINE V blend(const V a, const V b, const __m256i mask) noexcept {return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(mask));}
+        static ALWAYS_INLINE void store_idx(int64_t *p, const __m256i idx) noexcept {
+            int32_t t[8]; _mm256_storeu_si256((__m256i *) t, idx);
+            for (int i=0; i<8; ++i) p[i] = t[i];
+        }
+    };
+
+    template<> struct SimdOps<double> {
+        typedef __m256d V;
+        static constexpr int width = 4;
+        static ALWAYS_INLINE V load(const double *p) noexcept {return _mm256_loadu_pd(p);}
+        static ALWAYS_INLINE void store(double *p, const V v) noexcept {_mm256_storeu_pd(p, v);}
+        static ALWAYS_INLINE V set1(const double a) noexcept {return _mm256_set1_pd(a);}
+        static ALWAYS_INLINE V min(const V a, const V b) noexcept {return _mm256_min_pd(a, b);}
+        static ALWAYS_INLINE V max(const V a, const V b) noexcept {return _mm256_max_pd(a, b);}
+        static ALWAYS_INLINE __m256i lt(const V a, const V b) noexcept {return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_LT_OQ));}
+        static ALWAYS_INLINE __m256i in_range(const V a, const V l, const V u) noexcept {
+            return _mm256_castpd_si256(_mm256_and_pd(_mm256_cmp_pd(a, l, _CMP_GE_OQ), _mm256_cmp_pd(a, u, _CMP_LE_OQ)));
+        }
+        static ALWAYS_INLINE int count(const __m256i mask) noexcept {return __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));}
+        static ALWAYS_INLINE __m256i idx_first() noexcept {return _mm256_setr_epi64x(0, 1, 2, 3);}
+        static ALWAYS_INLINE __m256i idx_next(const __m256i idx) noexcept {return _mm256_add_epi64(idx, _mm256_set1_epi64x(4));}
+        static ALWAYS_INLINE V blend(const V a, const V b, const __m256i mask) noexcept {return _mm256_blendv_pd(a, b, _mm256_castsi256_pd(mask));}
+        static ALWAYS_INLINE void store_idx(int64_t *p, const __m256i idx) noexcept {_mm256_storeu_si256((__m256i *) p, idx);}
+    };
+#endif
+
+    //! out[i] = clamp(in[i], l, u). in and out may be the same array.
+    template<typename T>
+    inline void clamp_array(const T * const in, T * const out, const size_t n, const T l, const T u) noexcept {
+        size_t i = 0;
+#if defined(__AVX2__)
+        typedef SimdOps<T> S;
+        const typename S::V vl = S::set1(l), vu = S::set1(u);
+        // Operand order matters for float: max/min return the second operand if either is NaN.
+        for (; i < (n & ~size_t(S::width - 1)); i += S::width) S::store(out + i, S::min(vu, S::max(vl, S::load(in + i))));
+#endif
+        for (; i < n; ++i) {
+            const T t = (in[i] < l) ? l : in[i];
+            out[i] = (t > u) ? u : t;
+        }
+    }
+
+    //! Find the min and max of n > 0 values.
+    template<typename T>
+    inline void minmax_reduce(const T * const in, const size_t n, T &min_value, T &max_value) noexcept {
+        T mn = in[0], mx = in[0];
+        size_t i = 0;
+#if defined(__AVX2__)
+        typedef SimdOps<T> S;
+        if (n >= size_t(S::width)) {
+            typename S::V vmin = S::load(in), vmax = vmin;
+            for (i = S::width; i < (n & ~size_t(S::width - 1)); i += S::width) {
+                const typename S::V v = S::load(in + i);
+                vmin = S::min(vmin, v);
+                vmax = S::max(vmax, v);
+            }
+            T tmin[S::width], tmax[S::width];
+            S::store(tmin, vmin);
+            S::store(tmax, vmax);
+            for (int j=0; j<S::width; ++j) {
+                mn = (tmin[j] < mn) ? tmin[j] : mn;
+                mx = (tmax[j] > mx) ? tmax[j] : mx;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            mn = (in[i] < mn) ? in[i] : mn;
+            mx = (in[i] > mx) ? in[i] : mx;
+        }
+        min_value = mn;
+        max_value = mx;
+    }
+
+    //! Index of the first smallest (IsMax=false) or first largest (IsMax=true) of n > 0 values.
+    template<bool IsMax, typename T>
+    inline size_t arg_extreme(const T * const in, const size_t n) noexcept {
+        size_t best_i = 0;
+        T best = in[0];
+        size_t i = 0;
+#if defined(__AVX2__)
+        typedef SimdOps<T> S;
+        if ((n >= size_t(S::width)) && (n < (size_t(1) << 31))) { //int32 lanes hold the indices of int32_t and float.
+            typename S::V vbest = S::load(in);
+            __m256i vbest_idx = S::idx_first(), vidx = vbest_idx;
+            for (i = S::width; i < (n & ~size_t(S::width - 1)); i += S::width) {
+                vidx = S::idx_next(vidx);
+                const typename S::V v = S::load(in + i);
+                const __m256i better = IsMax ? S::lt(vbest, v) : S::lt(v, vbest); //Strict, so each lane keeps its first.
+                vbest = S::blend(vbest, v, better);
+                vbest_idx = _mm256_blendv_epi8(vbest_idx, vidx, better);
+            }
+            T tbest[S::width];
+            int64_t tidx[S::width];
+            S::store(tbest, vbest);
+            S::store_idx(tidx, vbest_idx);
+            best = tbest[0];
+            best_i = tidx[0];
+            for (int j=1; j<S::width; ++j) {
+                const bool better = IsMax ? (tbest[j] > best) : (tbest[j] < best);
+                if (better || ((tbest[j] == best) && (size_t(tidx[j]) < best_i))) {
+                    best = tbest[j];
+                    best_i = tidx[j];
+                }
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            const bool better = IsMax ? (in[i] > best) : (in[i] < best);
+            best_i = better ? i : best_i;
+            best = better ? in[i] : best;
+        }
+        return best_i;
+    }
+
+    template<typename T>
+    inline size_t argmin(const T * const in, const size_t n) noexcept {return arg_extreme<false>(in, n);}
+
+    template<typename T>
+    inline size_t argmax(const T * const in, const size_t n) noexcept {return arg_extreme<true>(in, n);}
+
+    //! Number of values with between(in[i], l, u), i.e. l <= in[i] <= u.
+    template<typename T>
+    inline size_t count_between(const T * const in, const size_t n, const T l, const T u) noexcept {
+        size_t count = 0;
+        size_t i = 0;
+#if defined(__AVX2__)
+        typedef SimdOps<T> S;
+        const typename S::V vl = S::set1(l), vu = S::set1(u);
+        for (; i < (n & ~size_t(S::width - 1)); i += S::width) count += S::count(S::in_range(S::load(in + i), vl, vu));
+#endif
+        for (; i < n; ++i) count += (in[i] >= l) && (in[i] <= u);
+        return count;
+    }
+}
+
+#endif //TC_MIN_MAX_CLAMP_BETWEEN_H
@@ -0,0 +1,156 @@
+#ifndef TC_INT_MATH_H
+#define TC_INT_MATH_H 1
+
+#include "../defines/tc_defines.h"
+
+#include <cstdint>
+#include <type_traits>
+
+//==========================//
+//=== TC Integer Math ======//
+//==========================//
+/*!
+ * Branch-free integer kernels. Unlike tc_math::fast_int_log2 these are defined for zero, don't need x86 asm and
+ * most are constexpr. FastDivisor replaces division/modulo by a runtime-invariant divisor with a multiply and shifts.
+ * EXAMPLE Usage:
+ *   static_assert(tc_math::ilog2(1024u) == 10, "");
+ *   const tc_math::FastDivisor<uint32_t> bucket_count(num_buckets); //Precompute the magic number once.
+ *   const uint32_t bucket = hash % bucket_count; //Same as hash % num_buckets, but without the div instruction.
+ */
+
+namespace tc_math {
+    //! Number of set bits.
+    constexpr int popcount(const uint32_t x) noexcept {return __builtin_popcount(x);}
+    constexpr int popcount(const uint64_t x) noexcept {return __builtin_popcountll(x);}
+
+    //! Number of leading zero bits. Defined as the bit width for x=0.
+    constexpr int clz(const uint32_t x) noexcept {return (x == 0) ? 32 : __builtin_clz(x);}
+    constexpr int clz(const uint64_t x) noexcept {return (x == 0) ? 64 : __builtin_clzll(x);}
+
+    //! Number of trailing zero bits. Defined as the bit width for x=0.
+    constexpr int ctz(const uint32_t x) noexcept {return (x == 0) ? 32 : __builtin_ctz(x);}
+    constexpr int ctz(const uint64_t x) noexcept {return (x == 0) ? 64 : __builtin_ctzll(x);}
+
+    //! Number of trailing zero bits. The result is undefined for x=0, but it has no check.
+    ALWAYS_INLINE int ctz_nonzero(const uint32_t x) noexcept {return __builtin_ctz(x);}
+    ALWAYS_INLINE int ctz_nonzero(const uint64_t x) noexcept {return __builtin_ctzll(x);}
+
+    //! floor(log2(x)). Returns -1 for x=0.
+    constexpr int ilog2(const uint32_t x) noexcept {return 31 - clz(x);}
+    constexpr int ilog2(const uint64_t x) noexcept {return 63 - clz(x);}
+
+    //! ceil(log2(x)). Returns 0 for x=0 and x=1.
+    constexpr int ceil_log2(const uint32_t x) noexcept {return (x <= 1) ? 0 : ilog2(uint32_t(x - 1)) + 1;}
+    constexpr int ceil_log2(const uint64_t x) noexcept {return (x <= 1) ? 0 : ilog2(uint64_t(x - 1)) + 1;}
+
+    //! Powers of ten used by ilog10. A template so that the table can be defined in the header.
+    template<typename Dummy = void>
+    struct IntMathTables {
+        static constexpr uint64_t pow10_[20] = {
+            UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000), UINT64_C(100000),
+            UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+            UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000), UINT64_C(10000000000000),
+            UINT64_C(100000000000000), UINT64_C(1000000000000000), UINT64_C(10000000000000000),
+            UINT64_C(100000000000000000), UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+        };
+    };
+    template<typename Dummy> constexpr uint64_t IntMathTables<Dummy>::pow10_[20];
+
+    //! floor(log10(x)). Returns -1 for x=0.
+    constexpr int ilog10(const uint64_t x) noexcept {
+        // 1233/4096 ~= log10(2) gives an estimate that is at most one too large; the table lookup corrects it.
+        return ((ilog2(x) + 1) * 1233 >> 12) - (x < IntMathTables<>::pow10_[(ilog2(x) + 1) * 1233 >> 12]);
+    }
+    constexpr int ilog10(const uint32_t x) noexcept {return ilog10(uint64_t(x));}
+
+    //! True if x is a power of two. False for x=0.
+    template<typename T>
+    constexpr bool is_pow2(const T x) noexcept {return (x != 0) && ((x & (x - 1)) == 0);}
+
+    //! Smallest power of two >= x. Returns 1 for x=0. Undefined if the result does not fit in the type.
+    constexpr uint32_t next_pow2(const uint32_t x) noexcept {return uint32_t(1) << ceil_log2(x);}
+    constexpr uint64_t next_pow2(const uint64_t x) noexcept {return uint64_t(1) << ceil_log2(x);}
+
+    //! Largest power of two <= x. Returns 0 for x=0.
+    constexpr uint32_t prev_pow2(const uint32_t x) noexcept {return (x == 0) ? 0 : (uint32_t(1) << ilog2(x));}
+    constexpr uint64_t prev_pow2(const uint64_t x) noexcept {return (x == 0) ? 0 : (uint64_t(1) << ilog2(x));}
+
+    //! Binary (Stein's) GCD. Note: binary_gcd(a, 0) is a; binary_gcd(0, b) is b;
+    template<typename T>
+    inline T binary_gcd(T a, T b) noexcept {
+        static_assert(std::is_unsigned<T>::value, "binary_gcd requires an unsigned type.");
+        if (a == 0) return b;
+        if (b == 0) return a;
+
+        // The ctz of the difference is started before the min/abs, which shortens the dependency chain per iteration.
+        int az = ctz_nonzero(a);
+        const int bz = ctz_nonzero(b);
+        const int shift = (az < bz) ? az : bz; //Common factors of two.
+        b >>= bz;
+
+        while (a != 0) {
+            a >>= az;
+            const T diff = b - a; //Wraps, but has the same trailing zeros as |b - a|.
+            az = ctz_nonzero(diff); //Unused when diff=0, because the loop then ends.
+            const T mask = T(0) - T(a > b); //All ones if a > b. Branch free, the comparison is unpredictable.
+            b = a ^ ((a ^ b) & mask); //min(a, b)
+            a = (diff ^ mask) - mask; //|b - a|
+        }
+
+        return b << shift;
+    }
+
+    //! Double width type used by FastDivisor for the high half of a multiply.
+    template<typename T> struct WideUInt;
+    template<> struct WideUInt<uint32_t> {typedef uint64_t type;};
+    template<> struct WideUInt<uint64_t> {typedef __uint128_t type;};
+
+    /*!
+     * Division and modulo by a runtime-invariant divisor (as in libdivide). Uses Granlund & Montgomery, 1994,
+     * Division by Invariant Integers using Multiplication - the branch free version that is valid for any d >= 1.
+     */
+    template<typename T>
+    class FastDivisor {
+        static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value,
+                      "FastDivisor supports uint32_t and uint64_t.");
+        typedef typename WideUInt<T>::type W;
+        static constexpr int num_bits_ = sizeof(T) * 8;
+
+    public:
+        explicit FastDivisor(const T d = 1) noexcept {init(d);}
+
+        void init(const T d) noexcept {
+            BBBD(d == 0)
+            d_ = d;
+            const int l = ceil_log2(d);
+            const T two_l_minus_d = (l == num_bits_) ? T(T(0) - d) : T((T(1) << l) - d); //2^l - d
+            m_ = T((W(two_l_minus_d) << num_bits_) / d + 1);
+            sh1_ = (l < 1) ? l : 1;
+            sh2_ = (l > 1) ? (l - 1) : 0;
+        }
+
+        //! n / d
+        ALWAYS_INLINE T divide(const T n) const noexcept {
+            const T t1 = T((W(m_) * n) >> num_bits_);
+            return (t1 + ((n - t1) >> sh1_)) >> sh2_;
+        }
+
+        //! n % d
+        ALWAYS_INLINE T modulo(const T n) const noexcept {return n - divide(n) * d_;}
+
+        ALWAYS_INLINE T get_divisor() const noexcept {return d_;}
+
+    private:
+        T d_;//!< The divisor.
+        T m_;//!< The magic multiplier.
+        int sh1_, sh2_;//!< The post shifts.
+    };
+
+    template<typename T>
+    ALWAYS_INLINE T operator/(const T n, const FastDivisor<T> &d) noexcept {return d.divide(n);}
+
+    template<typename T>
+    ALWAYS_INLINE T operator%(const T n, const FastDivisor<T> &d) noexcept {return d.modulo(n);}
+}
+
+#endif //TC_INT_MATH_H
@@ -50,6 +50,115 @@ namespace tc_math {
         uid.i_ = int64_t(double((int64_t(1) << 52) / log(2.0)) * x + double((int64_t(1) << 52) * 1023 - 0)); //c=0 for 1.0 at zero.
         return uid.d_;
     }
+
+    /*!
+     * Minimax polynomials for 2^f with f in [-0.5, 0.5], used by fast_exp<Degree>(). The coefficients minimise the
+     * max relative error, which is listed per degree.
+     */
+    template<int Degree> struct FastExpPoly;
+
+    template<> struct FastExpPoly<1> { //Max rel error 3.0e-2.
+        static ALWAYS_INLINE double eval(const double f) noexcept {
+            return 1.0290300068886798 + f * 0.68602000459245323;
+        }
+    };
+
+    template<> struct FastExpPoly<2> { //Max rel error 1.7e-3.
+        static ALWAYS_INLINE double eval(const double f) noexcept {
+            return 1.0004431420417386 + f * (0.70344800601393411 + f * 0.23842893550392161);
+        }
+    };
+
+    template<> struct FastExpPoly<3> { //Max rel error 7.5e-5.
+        static ALWAYS_INLINE double eval(const double f) noexcept {
+            return 0.99992807353515966 + f * (0.69326098545424573 + f * (0.24261112222375324 + f * 0.055171669092611662));
+        }
+    };
+
+    template<> struct FastExpPoly<4> { //Max rel error 2.6e-6.
+        static ALWAYS_INLINE double eval(const double f) noexcept {
+            return 0.99999926144693115 + f * (0.69312181474298668 + f * (0.24024744824991691 +
+                   f * (0.055917860306325652 + f * 0.0095701020146293256)));
+        }
+    };
+
+    template<> struct FastExpPoly<5> { //Max rel error 7.5e-8.
+        static ALWAYS_INLINE double eval(const double f) noexcept {
+            return 1.0000000716546416 + f * (0.69314696706526493 + f * (0.24022119723969178 +
+                   f * (0.055507132728753912 + f * (0.0096755413310213911 + f * 0.0013276472167819943))));
+        }
+    };
+
+    //! Approximate exp with a polynomial correction of the mantissa. Degree in [1, 5] trades accuracy for speed.
+    template<int Degree>
+    ALWAYS_INLINE double fast_exp(const double x) noexcept {
+        // exp(x) = 2^t with t = x/ln(2) = k + f, k = round(t) and f in [-0.5, 0.5].
+        // - 2^f is approximated by the minimax polynomial and 2^k is injected into its exponent field.
+        // - Adding 1.5*2^52 rounds t to the nearest integer k and leaves k in the low bits of the mantissa.
+        // - Valid for x in approx range (-708, 709).
+        union{double d_; int64_t i_;} ukt, up;
+        const double t = x * double(1.0 / log(2.0));
+        ukt.d_ = t + 6755399441055744.0; //0x1.8p52
+        const double k = ukt.d_ - 6755399441055744.0;
+        const double f = t - k;
+        up.d_ = FastExpPoly<Degree>::eval(f);
+        up.i_ += int64_t(uint64_t(int64_t(int32_t(ukt.i_))) << 52);
+        return up.d_;
+    }
+
+    //! Approximate log adapted from Schraudolph, 1999 - double precision floating point version.
+    ALWAYS_INLINE double fast_log_64(const double x) noexcept {
+        // The inverse of fast_exp_64: the bits of x read as an integer are a piecewise linear approx of log2(x).
+        // - Valid for x > 0.0.
+        union{double d_; int64_t i_;} uid;
+        uid.d_ = x;
+        return (double(uid.i_) - double((int64_t(1) << 52) * 1023)) * double(log(2.0) / (int64_t(1) << 52));
+    }
+
+    //! Approximate pow(a, b) as fast_exp_64(b * fast_log_64(a)). Valid for a > 0.0.
+    ALWAYS_INLINE double fast_pow_64(const double a, const double b) noexcept {
+        return fast_exp_64(b * fast_log_64(a));
+    }
+
+    //! Approximate sigmoid using fast_exp_64.
+    ALWAYS_INLINE double fast_sigmoid_64(const double x) noexcept {
+        return 1.0 / (1.0 + fast_exp_64(-x));
+    }
+
+    //! Approximate tanh using fast_exp_64. tanh(x) = 1 - 2/(1+exp(2x)).
+    ALWAYS_INLINE double fast_tanh_64(const double x) noexcept {
+        return 1.0 - 2.0 / (1.0 + fast_exp_64(2.0 * x));
+    }
+
+    //! Approximate exp by Schraudolph, 1999 - single precision floating point version.
+    ALWAYS_INLINE float fast_expf(const float x) noexcept {
+        // - Valid for x in approx range (-87, 88).
+        union{float f_; int32_t i_;} uif;
+        uif.i_ = int32_t(float((1<<23) / log(2.0)) * x + float((1<<23) * 127)); //c=0 for 1.0 at zero.
+        return uif.f_;
+    }
+
+    //! Approximate log by Schraudolph, 1999 - single precision floating point version. Valid for x > 0.0f.
+    ALWAYS_INLINE float fast_logf(const float x) noexcept {
+        union{float f_; int32_t i_;} uif;
+        uif.f_ = x;
+        return (float(uif.i_) - float((1<<23) * 127)) * float(log(2.0) / (1<<23));
+    }
+
+    //! Approximate powf(a, b) as fast_expf(b * fast_logf(a)). Valid for a > 0.0f.
+    ALWAYS_INLINE float fast_powf(const float a, const float b) noexcept {
+        return fast_expf(b * fast_logf(a));
+    }
+
+    //! Approximate sigmoid using fast_expf.
+    ALWAYS_INLINE float fast_sigmoidf(const float x) noexcept {
+        return 1.0f / (1.0f + fast_expf(-x));
+    }
+
+    //! Approximate tanh using fast_expf.
+    ALWAYS_INLINE float fast_tanhf(const float x) noexcept {
+        return 1.0f - 2.0f / (1.0f + fast_expf(2.0f * x));
+    }
 }
 
 #endif //TC_MATH_H
@@ -0,0 +1,269 @@
+#ifndef TC_MATH_SIMD_H
+#define TC_MATH_SIMD_H 1
+
+#include "../defines/tc_defines.h"
+#include "../math/tc_math.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+//=================================//
+//=== TC Math - Array kernels =====//
+//=================================//
+/*!
+ * Array versions of the Schraudolph style fast_exp, fast_log, fast_pow, fast_sigmoid and fast_tanh.
+ * The AVX-512 and AVX2 paths are compiled in when the target supports them (e.g. -mavx2 or -march=native),
+ * otherwise only the scalar loop remains. The remainder of each array is done with the scalar versions.
+ * EXAMPLE Usage:
+ *   tc_math::fast_exp(in, out, n); //out[i] ~= exp(in[i])
+ *   tc_math::fast_sigmoid(in, out, n); //out[i] ~= 1/(1+exp(-in[i]))
+ * The inputs are clamped to the valid range of the approximation, (-700, 700) for double and (-87, 88) for float.
+ */
+
+namespace tc_math {
+    namespace simd_detail {
+        constexpr double ln2_d = 0.693147180559945309417;
+        constexpr double exp_min_d = -700.0;
+        constexpr double exp_max_d = 700.0;
+        constexpr float exp_min_f = -87.0f;
+        constexpr float exp_max_f = 88.0f;
+
+        ALWAYS_INLINE double clamp_exp_arg(const double x) noexcept {return std::min(std::max(x, exp_min_d), exp_max_d);}
+        ALWAYS_INLINE float clamp_exp_arg(const float x) noexcept {return std::min(std::max(x, exp_min_f), exp_max_f);}
+
+        //=== exp ===//
+        struct ExpOp {
+            static ALWAYS_INLINE double scalar(const double x) noexcept {return fast_exp_64(clamp_exp_arg(x));}
+            static ALWAYS_INLINE float scalar(const float x) noexcept {return fast_expf(clamp_exp_arg(x));}
+
+#if defined(__AVX2__)
+            //! 2^t = 2^k * (1+f) with k=floor(t); the bits of 1+f get k injected into the exponent field.
+            static ALWAYS_INLINE __m256d simd(__m256d x) noexcept {
+                x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(exp_min_d)), _mm256_set1_pd(exp_max_d));
+                const __m256d t = _mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.0 / ln2_d)), _mm256_set1_pd(1023.0));
+                const __m256d k = _mm256_floor_pd(t);
+                const __m256d m = _mm256_add_pd(_mm256_sub_pd(t, k), _mm256_set1_pd(1.0));
+                const __m256i k64 = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(k));
+                const __m256i e = _mm256_slli_epi64(_mm256_sub_epi64(k64, _mm256_set1_epi64x(1023)), 52);
+                return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(m), e));
+            }
+
+            static ALWAYS_INLINE __m256 simd(__m256 x) noexcept {
+                x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(exp_min_f)), _mm256_set1_ps(exp_max_f));
+                const __m256 y = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(float((1<<23) / ln2_d))),
+                                               _mm256_set1_ps(float((1<<23) * 127)));
+                return _mm256_castsi256_ps(_mm256_cvttps_epi32(y));
+            }
+#endif
+#if defined(__AVX512F__)
+            static ALWAYS_INLINE __m512d simd(__m512d x) noexcept {
+                x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(exp_min_d)), _mm512_set1_pd(exp_max_d));
+                const __m512d t = _mm512_add_pd(_mm512_mul_pd(x, _mm512_set1_pd(1.0 / ln2_d)), _mm512_set1_pd(1023.0));
+                const __m512d k = _mm512_roundscale_pd(t, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+                const __m512d m = _mm512_add_pd(_mm512_sub_pd(t, k), _mm512_set1_pd(1.0));
+                const __m512i k64 = _mm512_cvtepi32_epi64(_mm512_cvttpd_epi32(k));
+                const __m512i e = _mm512_slli_epi64(_mm512_sub_epi64(k64, _mm512_set1_epi64(1023)), 52);
+                return _mm512_castsi512_pd(_mm512_add_epi64(_mm512_castpd_si512(m), e));
+            }
+
+            static ALWAYS_INLINE __m512 simd(__m512 x) noexcept {
+                x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(exp_min_f)), _mm512_set1_ps(exp_max_f));
+                const __m512 y = _mm512_add_ps(_mm512_mul_ps(x, _mm512_set1_ps(float((1<<23) / ln2_d))),
+                                               _mm512_set1_ps(float((1<<23) * 127)));
+                return _mm512_castsi512_ps(_mm512_cvttps_epi32(y));
+            }
+#endif
+        };
+
+        //=== log ===//
+        struct LogOp {
+            static ALWAYS_INLINE double scalar(const double x) noexcept {return fast_log_64(x);}
+            static ALWAYS_INLINE float scalar(const float x) noexcept {return fast_logf(x);}
+
+#if defined(__AVX2__)
+            //! log2(x) ~= (E - 1023) + (m - 1) with E the biased exponent and m the mantissa in [1,2).
+            static ALWAYS_INLINE __m256d simd(const __m256d x) noexcept {
+                const __m256i bits = _mm256_castpd_si256(x);
+                // E is converted to double by injecting it into the mantissa of 2^52.
+                const __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52),
+                                                                                    _mm256_set1_epi64x(0x4330000000000000))),
+                                                _mm256_set1_pd(4503599627370496.0)); //0x1p52
+                const __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF)),
+                                                                      _mm256_set1_epi64x(0x3FF0000000000000)));
+                return _mm256_mul_pd(_mm256_add_pd(e, _mm256_sub_pd(m, _mm256_set1_pd(1024.0))), _mm256_set1_pd(ln2_d));
+            }
+
+            static ALWAYS_INLINE __m256 simd(const __m256 x) noexcept {
+                const __m256 y = _mm256_cvtepi32_ps(_mm256_castps_si256(x));
+                return _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(float((1<<23) * 127))), _mm256_set1_ps(float(ln2_d / (1<<23))));
+            }
+#endif
+#if defined(__AVX512F__)
+            static ALWAYS_INLINE __m512d simd(const __m512d x) noexcept {
+                const __m512i bits = _mm512_castpd_si512(x);
+                const __m512d e = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52),
+                                                                                    _mm512_set1_epi64(0x4330000000000000))),
+                                                _mm512_set1_pd(4503599627370496.0)); //0x1p52
+                const __m512d m = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFF)),
+                                                                      _mm512_set1_epi64(0x3FF0000000000000)));
+                return _mm512_mul_pd(_mm512_add_pd(e, _mm512_sub_pd(m, _mm512_set1_pd(1024.0))), _mm512_set1_pd(ln2_d));
+            }
+
+            static ALWAYS_INLINE __m512 simd(const __m512 x) noexcept {
+                const __m512 y = _mm512_cvtepi32_ps(_mm512_castps_si512(x));
+                return _mm512_mul_ps(_mm512_sub_ps(y, _mm512_set1_ps(float((1<<23) * 127))), _mm512_set1_ps(float(ln2_d / (1<<23))));
+            }
+#endif
+        };
+
+        //=== sigmoid = 1/(1+exp(-x)) ===//
+        struct SigmoidOp {
+            static ALWAYS_INLINE double scalar(const double x) noexcept {return 1.0 / (1.0 + ExpOp::scalar(-x));}
+            static ALWAYS_INLINE float scalar(const float x) noexcept {return 1.0f / (1.0f + ExpOp::scalar(-x));}
+
+#if defined(__AVX2__)
+            static ALWAYS_INLINE __m256d simd(const __m256d x) noexcept {
+                const __m256d one = _mm256_set1_pd(1.0);
+                return _mm256_div_pd(one, _mm256_add_pd(one, ExpOp::simd(_mm256_sub_pd(_mm256_setzero_pd(), x))));
+            }
+
+            static ALWAYS_INLINE __m256 simd(const __m256 x) noexcept {
+                const __m256 one = _mm256_set1_ps(1.0f);
+                return _mm256_div_ps(one, _mm256_add_ps(one, ExpOp::simd(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+            }
+#endif
+#if defined(__AVX512F__)
+            static ALWAYS_INLINE __m512d simd(const __m512d x) noexcept {
+                const __m512d one = _mm512_set1_pd(1.0);
+                return _mm512_div_pd(one, _mm512_add_pd(one, ExpOp::simd(_mm512_sub_pd(_mm512_setzero_pd(), x))));
+            }
+
+            static ALWAYS_INLINE __m512 simd(const __m512 x) noexcept {
+                const __m512 one = _mm512_set1_ps(1.0f);
+                return _mm512_div_ps(one, _mm512_add_ps(one, ExpOp::simd(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+            }
+#endif
+        };
+
+        //=== tanh = 1 - 2/(1+exp(2x)) ===//
+        struct TanhOp {
+            static ALWAYS_INLINE double scalar(const double x) noexcept {return 1.0 - 2.0 / (1.0 + ExpOp::scalar(2.0 * x));}
+            static ALWAYS_INLINE float scalar(const float x) noexcept {return 1.0f - 2.0f / (1.0f + ExpOp::scalar(2.0f * x));}
+
+#if defined(__AVX2__)
+            static ALWAYS_INLINE __m256d simd(const __m256d x) noexcept {
+                const __m256d one = _mm256_set1_pd(1.0);
+                const __m256d e = ExpOp::simd(_mm256_add_pd(x, x));
+                return _mm256_sub_pd(one, _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(one, e)));
+            }
+
+            static ALWAYS_INLINE __m256 simd(const __m256 x) noexcept {
+                const __m256 one = _mm256_set1_ps(1.0f);
+                const __m256 e = ExpOp::simd(_mm256_add_ps(x, x));
+                return _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(one, e)));
+            }
+#endif
+#if defined(__AVX512F__)
+            static ALWAYS_INLINE __m512d simd(const __m512d x) noexcept {
+                const __m512d one = _mm512_set1_pd(1.0);
+                const __m512d e = ExpOp::simd(_mm512_add_pd(x, x));
+                return _mm512_sub_pd(one, _mm512_div_pd(_mm512_set1_pd(2.0), _mm512_add_pd(one, e)));
+            }
+
+            static ALWAYS_INLINE __m512 simd(const __m512 x) noexcept {
+                const __m512 one = _mm512_set1_ps(1.0f);
+                const __m512 e = ExpOp::simd(_mm512_add_ps(x, x));
+                return _mm512_sub_ps(one, _mm512_div_ps(_mm512_set1_ps(2.0f), _mm512_add_ps(one, e)));
+            }
+#endif
+        };
+
+        //=== pow = exp(b * log(a)) ===//
+        struct PowOp {
+            static ALWAYS_INLINE double scalar(const double a, const double b) noexcept {return ExpOp::scalar(b * LogOp::scalar(a));}
+            static ALWAYS_INLINE float scalar(const float a, const float b) noexcept {return ExpOp::scalar(b * LogOp::scalar(a));}
+
+#if defined(__AVX2__)
+            static ALWAYS_INLINE __m256d simd(const __m256d a, const __m256d b) noexcept {return ExpOp::simd(_mm256_mul_pd(b, LogOp::simd(a)));}
+            static ALWAYS_INLINE __m256 simd(const __m256 a, const __m256 b) noexcept {return ExpOp::simd(_mm256_mul_ps(b, LogOp::simd(a)));}
+#endif
+#if defined(__AVX512F__)
+            static ALWAYS_INLINE __m512d simd(const __m512d a, const __m512d b) noexcept {return ExpOp::simd(_mm512_mul_pd(b, LogOp::simd(a)));}
+            static ALWAYS_INLINE __m512 simd(const __m512 a, const __m512 b) noexcept {return ExpOp::simd(_mm512_mul_ps(b, LogOp::simd(a)));}
+#endif
+        };
+
+        //! Apply Op to every element of in. Widest available vectors first, scalar remainder last.
+        template<class Op>
+        ALWAYS_INLINE void transform(const double * const in, double * const out, const size_t n) noexcept {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (n & ~size_t(7)); i += 8) _mm512_storeu_pd(out + i, Op::simd(_mm512_loadu_pd(in + i)));
+#endif
+#if defined(__AVX2__)
+            for (; i < (n & ~size_t(3)); i += 4) _mm256_storeu_pd(out + i, Op::simd(_mm256_loadu_pd(in + i)));
+#endif
+            for (; i < n; ++i) out[i] = Op::scalar(in[i]);
+        }
+
+        template<class Op>
+        ALWAYS_INLINE void transform(const float * const in, float * const out, const size_t n) noexcept {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (n & ~size_t(15)); i += 16) _mm512_storeu_ps(out + i, Op::simd(_mm512_loadu_ps(in + i)));
+#endif
+#if defined(__AVX2__)
+            for (; i < (n & ~size_t(7)); i += 8) _mm256_storeu_ps(out + i, Op::simd(_mm256_loadu_ps(in + i)));
+#endif
+            for (; i < n; ++i) out[i] = Op::scalar(in[i]);
+        }
+
+        template<class Op>
+        ALWAYS_INLINE void transform(const double * const in_a, const double * const in_b, double * const out, const size_t n) noexcept {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (n & ~size_t(7)); i += 8) _mm512_storeu_pd(out + i, Op::simd(_mm512_loadu_pd(in_a + i), _mm512_loadu_pd(in_b + i)));
+#endif
+#if defined(__AVX2__)
+            for (; i < (n & ~size_t(3)); i += 4) _mm256_storeu_pd(out + i, Op::simd(_mm256_loadu_pd(in_a + i), _mm256_loadu_pd(in_b + i)));
+#endif
+            for (; i < n; ++i) out[i] = Op::scalar(in_a[i], in_b[i]);
+        }
+
+        template<class Op>
+        ALWAYS_INLINE void transform(const float * const in_a, const float * const in_b, float * const out, const size_t n) noexcept {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (n & ~size_t(15)); i += 16) _mm512_storeu_ps(out + i, Op::simd(_mm512_loadu_ps(in_a + i), _mm512_loadu_ps(in_b + i)));
+#endif
+#if defined(__AVX2__)
+            for (; i < (n & ~size_t(7)); i += 8) _mm256_storeu_ps(out + i, Op::simd(_mm256_loadu_ps(in_a + i), _mm256_loadu_ps(in_b + i)));
+#endif
+            for (; i < n; ++i) out[i] = Op::scalar(in_a[i], in_b[i]);
+        }
+    }
+
+    //! Approximate exp of n values. in and out may be the same array.
+    inline void fast_exp(const double * const in, double * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::ExpOp>(in, out, n);}
+    inline void fast_exp(const float * const in, float * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::ExpOp>(in, out, n);}
+
+    //! Approximate log of n values. Valid for in[i] > 0.
+    inline void fast_log(const double * const in, double * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::LogOp>(in, out, n);}
+    inline void fast_log(const float * const in, float * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::LogOp>(in, out, n);}
+
+    //! Approximate pow(a[i], b[i]) of n values. Valid for a[i] > 0.
+    inline void fast_pow(const double * const a, const double * const b, double * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::PowOp>(a, b, out, n);}
+    inline void fast_pow(const float * const a, const float * const b, float * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::PowOp>(a, b, out, n);}
+
+    //! Approximate sigmoid of n values.
+    inline void fast_sigmoid(const double * const in, double * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::SigmoidOp>(in, out, n);}
+    inline void fast_sigmoid(const float * const in, float * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::SigmoidOp>(in, out, n);}
+
+    //! Approximate tanh of n values.
+    inline void fast_tanh(const double * const in, double * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::TanhOp>(in, out, n);}
+    inline void fast_tanh(const float * const in, float * const out, const size_t n) noexcept {simd_detail::transform<simd_detail::TanhOp>(in, out, n);}
+}
+
+#endif //TC_MATH_SIMD_H
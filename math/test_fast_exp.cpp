@@ -58,6 +58,49 @@ double test_fast_exp_perf(const uint64_t num_iterations) {
     return (end_time - start_time) / num_iterations;
 }
 
+//! Test the performance of the testing code with `fast_exp<Degree>`.
+template<int Degree>
+double test_fast_exp_poly_perf(const uint64_t num_iterations) {
+    double sum_sink = 0.0;
+    const double start_time = TCTimer::get_time();
+    
+    for (uint64_t i=0; i<num_iterations; ++i) {
+        const double r = rng.next_double();
+        sum_sink += tc_math::fast_exp<Degree>(r);
+    }
+    
+    const double end_time = TCTimer::get_time();
+    DBN(sum_sink)
+    return (end_time - start_time) / num_iterations;
+}
+
+//! Find the max relative error of an exp approximation over [x_l, x_r).
+double test_max_rel_error(double (*approx_exp)(const double),
+                          const double x_l, const double x_r,
+                          const uint64_t num_samples) {
+    const double dx = (x_r - x_l) / num_samples;
+    double max_rel_error = 0.0;
+    
+    for (double x=x_l; x<x_r; x+=dx) {
+        const double e = exp(x);
+        const double rel_sample_error = fabs(approx_exp(x) - e) / e;
+        if (rel_sample_error > max_rel_error) max_rel_error = rel_sample_error;
+    }
+    
+    return max_rel_error;
+}
+
+//! Report ns/call and max relative error of `fast_exp<Degree>`.
+template<int Degree>
+void report_fast_exp_poly(const uint64_t num_iterations, const double baseline_perf) {
+    const double perf = test_fast_exp_poly_perf<Degree>(num_iterations);
+    
+    std::cout << "fast_exp<" << Degree << ">: "
+              << (perf - baseline_perf) * 1.0e9 << " ns/call, max rel error = "
+              << test_max_rel_error(tc_math::fast_exp<Degree>, -700.0, 700.0, 10000000) << "\n";
+    std::cout.flush();
+}
+
 //! Sigmoid using `exp`.
 double sigmoid(const double x)
 {
@@ -128,6 +171,14 @@ int main(void)
     
     std::cout << "\n";
     std::cout << "Average abs_sample_error = " << test_accuracy(-5.5, 5.5, 1000) << "\n";
+    std::cout << "fast_exp_64 max rel error = " << test_max_rel_error(tc_math::fast_exp_64, -700.0, 700.0, 10000000) << "\n";
+
+    std::cout << "\n";
+    report_fast_exp_poly<1>(num_iterations, baseline_perf);
+    report_fast_exp_poly<2>(num_iterations, baseline_perf);
+    report_fast_exp_poly<3>(num_iterations, baseline_perf);
+    report_fast_exp_poly<4>(num_iterations, baseline_perf);
+    report_fast_exp_poly<5>(num_iterations, baseline_perf);
 
     std::cout.flush();
 
@@ -0,0 +1,144 @@
+#include "../defines/tc_defines.h"
+
+#include "../math/tc_math.h"
+#include "../math/tc_math_simd.h"
+#include "../time/tc_timer.h"
+#include "../random/tc_random_funcs.h"
+#include "../platform_info/platform_info.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321); // Generally good fast generator.
+
+const size_t array_size = 4096; // Small enough to stay in L1/L2.
+const int num_repeats = 50000;
+
+//! Time an array kernel. Returns seconds per element.
+template<class T, class F>
+double time_array_kernel(const std::vector<T> &in, std::vector<T> &out, F kernel) {
+    double sum_sink = 0.0;
+    const double start_time = TCTimer::get_time();
+
+    for (int r=0; r<num_repeats; ++r) {
+        kernel(in.data(), out.data(), in.size());
+        sum_sink += out[r % in.size()];
+    }
+
+    const double end_time = TCTimer::get_time();
+    DBN(sum_sink)
+    return (end_time - start_time) / (double(num_repeats) * in.size());
+}
+
+//! Max absolute and relative error of out w.r.t. the reference function.
+template<class T, class F>
+void calc_max_error(const std::vector<T> &in, const std::vector<T> &out, F reference,
+                    double &max_abs_error, double &max_rel_error) {
+    max_abs_error = 0.0;
+    max_rel_error = 0.0;
+
+    for (size_t i=0; i<in.size(); ++i) {
+        const double ref = reference(double(in[i]));
+        const double abs_error = fabs(double(out[i]) - ref);
+        max_abs_error = std::max(max_abs_error, abs_error);
+        if (ref != 0.0) max_rel_error = std::max(max_rel_error, abs_error / fabs(ref));
+    }
+}
+
+template<class T, class FastF, class StdF, class RefF>
+void test_kernel(const std::string &name, const std::vector<T> &in, FastF fast_kernel, StdF std_kernel, RefF reference) {
+    std::vector<T> out(in.size(), T(0));
+
+    const double std_perf = time_array_kernel(in, out, std_kernel);
+    const double fast_perf = time_array_kernel(in, out, fast_kernel);
+    double max_abs_error, max_rel_error;
+    calc_max_error(in, out, reference, max_abs_error, max_rel_error);
+
+    std::cout << name << ": std = " << std_perf * 1.0e9 << " ns/element, fast = " << fast_perf * 1.0e9
+              << " ns/element, max abs error = " << max_abs_error << ", max rel error = " << max_rel_error << "\n";
+    std::cout.flush();
+}
+
+int main(void)
+{
+    DBN(platform_info::get_cpu_brand_string())
+    DBN(platform_info::get_compiler())
+
+    const double EXP_TSC_FREQ = 2.89992e+09; // Doesn't really matter when using get_time() aot get_tsc_time().
+    TCTimer::init_timer(EXP_TSC_FREQ);
+
+#if defined(__AVX512F__)
+    std::cout << "Using AVX-512 kernels.\n";
+#elif defined(__AVX2__)
+    std::cout << "Using AVX2 kernels.\n";
+#else
+    std::cout << "Using scalar kernels.\n";
+#endif
+
+    std::vector<double> in_d(array_size), in_pos_d(array_size), in_b_d(array_size);
+    std::vector<float> in_f(array_size), in_pos_f(array_size);
+
+    for (size_t i=0; i<array_size; ++i) {
+        in_d[i] = rng.next_double(-10.0, 10.0);
+        in_pos_d[i] = rng.next_double(0.001, 100.0);
+        in_b_d[i] = rng.next_double(-2.0, 2.0);
+        in_f[i] = float(in_d[i]);
+        in_pos_f[i] = float(in_pos_d[i]);
+    }
+
+    std::cout << "\n";
+
+    test_kernel("exp (double)", in_d,
+                [](const double *in, double *out, size_t n) {tc_math::fast_exp(in, out, n);},
+                [](const double *in, double *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = exp(in[i]);},
+                [](double x) {return exp(x);});
+    test_kernel("exp (float)", in_f,
+                [](const float *in, float *out, size_t n) {tc_math::fast_exp(in, out, n);},
+                [](const float *in, float *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = expf(in[i]);},
+                [](double x) {return exp(x);});
+    test_kernel("log (double)", in_pos_d,
+                [](const double *in, double *out, size_t n) {tc_math::fast_log(in, out, n);},
+                [](const double *in, double *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = log(in[i]);},
+                [](double x) {return log(x);});
+    test_kernel("log (float)", in_pos_f,
+                [](const float *in, float *out, size_t n) {tc_math::fast_log(in, out, n);},
+                [](const float *in, float *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = logf(in[i]);},
+                [](double x) {return log(x);});
+    test_kernel("sigmoid (double)", in_d,
+                [](const double *in, double *out, size_t n) {tc_math::fast_sigmoid(in, out, n);},
+                [](const double *in, double *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = 1.0 / (1.0 + exp(-in[i]));},
+                [](double x) {return 1.0 / (1.0 + exp(-x));});
+    test_kernel("sigmoid (float)", in_f,
+                [](const float *in, float *out, size_t n) {tc_math::fast_sigmoid(in, out, n);},
+                [](const float *in, float *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = 1.0f / (1.0f + expf(-in[i]));},
+                [](double x) {return 1.0 / (1.0 + exp(-x));});
+    test_kernel("tanh (double)", in_d,
+                [](const double *in, double *out, size_t n) {tc_math::fast_tanh(in, out, n);},
+                [](const double *in, double *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = tanh(in[i]);},
+                [](double x) {return tanh(x);});
+    test_kernel("tanh (float)", in_f,
+                [](const float *in, float *out, size_t n) {tc_math::fast_tanh(in, out, n);},
+                [](const float *in, float *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = tanhf(in[i]);},
+                [](double x) {return tanh(x);});
+
+    { // pow takes two arrays.
+        std::vector<double> out_d(array_size);
+        const double std_perf = time_array_kernel(in_pos_d, out_d,
+                                                  [&](const double *in, double *out, size_t n) {for (size_t i=0; i<n; ++i) out[i] = pow(in[i], in_b_d[i]);});
+        const double fast_perf = time_array_kernel(in_pos_d, out_d,
+                                                   [&](const double *in, double *out, size_t n) {tc_math::fast_pow(in, in_b_d.data(), out, n);});
+        double error = 0.0;
+        for (size_t i=0; i<array_size; ++i) {
+            const double ref = pow(in_pos_d[i], in_b_d[i]);
+            error = std::max(error, fabs(out_d[i] - ref) / ref);
+        }
+        std::cout << "pow (double): std = " << std_perf * 1.0e9 << " ns/element, fast = " << fast_perf * 1.0e9
+                  << " ns/element, max rel error = " << error << "\n";
+    }
+
+    std::cout.flush();
+
+    return 0;
+}
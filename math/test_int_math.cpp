@@ -0,0 +1,158 @@
+#include "../defines/tc_defines.h"
+
+#include "../math/tc_math.h"
+#include "../math/tc_int_math.h"
+#include "../time/tc_timer.h"
+#include "../random/tc_random_funcs.h"
+#include "../platform_info/platform_info.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321); // Generally good fast generator.
+
+static_assert(tc_math::ilog2(uint32_t(1)) == 0, "ilog2");
+static_assert(tc_math::ilog2(uint32_t(1024)) == 10, "ilog2");
+static_assert(tc_math::ilog2(uint32_t(0)) == -1, "ilog2");
+static_assert(tc_math::ilog10(uint64_t(999)) == 2, "ilog10");
+static_assert(tc_math::ilog10(uint64_t(1000)) == 3, "ilog10");
+static_assert(tc_math::next_pow2(uint32_t(1000)) == 1024, "next_pow2");
+static_assert(tc_math::prev_pow2(uint32_t(1000)) == 512, "prev_pow2");
+
+//! Count mismatches between the integer kernels and reference implementations.
+uint64_t test_correctness(const uint64_t num_samples) {
+    uint64_t num_errors = 0;
+
+    for (uint64_t i=0; i<num_samples; ++i) {
+        const uint32_t x = rng.next() >> rng.next(32); // Spread the samples over all magnitudes.
+        const uint32_t y = rng.next() >> rng.next(32);
+        const uint64_t x64 = (uint64_t(rng.next()) << 32 | rng.next()) >> rng.next(64);
+
+        { // Reference results by looping.
+            int l2 = -1;
+            for (uint32_t t=x; t!=0; t>>=1) ++l2;
+            uint64_t p10 = 1; int l10 = (x == 0) ? -1 : 0;
+            while ((x > 0) && (p10 * 10) <= x) {p10 *= 10; ++l10;}
+            const uint64_t prev_p2 = (x == 0) ? 0 : (uint64_t(1) << l2);
+            const uint64_t next_p2 = (prev_p2 == x) ? std::max(x, uint32_t(1)) : (prev_p2 << 1);
+
+            num_errors += tc_math::ilog2(x) != l2;
+            num_errors += tc_math::ilog10(x) != l10;
+            num_errors += tc_math::prev_pow2(x) != prev_p2;
+            num_errors += (next_p2 <= 0x80000000u) && (tc_math::next_pow2(x) != next_p2);
+        }
+
+        { // Reference gcd on 31-bit values.
+            const uint32_t a = x >> 1, b = y >> 1;
+            num_errors += tc_math::binary_gcd(a, b) != uint32_t(tc_math::gcd(int(a), int(b)));
+        }
+
+        if (y > 0) {
+            const tc_math::FastDivisor<uint32_t> fd(y);
+            num_errors += (x / fd) != (x / y);
+            num_errors += (x % fd) != (x % y);
+            num_errors += (0xFFFFFFFFu / fd) != (0xFFFFFFFFu / y);
+
+            const tc_math::FastDivisor<uint64_t> fd64(y);
+            num_errors += (x64 / fd64) != (x64 / y);
+        }
+
+        if (x64 > 0) {
+            const tc_math::FastDivisor<uint64_t> fd64(x64);
+            const uint64_t n = uint64_t(rng.next()) << 32 | rng.next();
+            num_errors += (n / fd64) != (n / x64);
+            num_errors += (n % fd64) != (n % x64);
+        }
+    }
+
+    return num_errors;
+}
+
+//! Time bucketing by hardware modulo with a divisor only known at runtime.
+double test_mod_perf(const std::vector<uint32_t> &hashes, const uint32_t num_buckets) {
+    uint64_t sum_sink = 0;
+    const double start_time = TCTimer::get_time();
+
+    for (int r=0; r<100; ++r) {
+        for (const uint32_t h : hashes) {
+            sum_sink += h % num_buckets;
+        }
+    }
+
+    const double end_time = TCTimer::get_time();
+    DBN(sum_sink)
+    return (end_time - start_time) / (100.0 * hashes.size());
+}
+
+//! Time bucketing with FastDivisor.
+double test_fast_mod_perf(const std::vector<uint32_t> &hashes, const uint32_t num_buckets) {
+    uint64_t sum_sink = 0;
+    const tc_math::FastDivisor<uint32_t> bucket_count(num_buckets);
+    const double start_time = TCTimer::get_time();
+
+    for (int r=0; r<100; ++r) {
+        for (const uint32_t h : hashes) {
+            sum_sink += h % bucket_count;
+        }
+    }
+
+    const double end_time = TCTimer::get_time();
+    DBN(sum_sink)
+    return (end_time - start_time) / (100.0 * hashes.size());
+}
+
+//! Time the recursive gcd vs the binary gcd.
+void test_gcd_perf(const uint64_t num_iterations, double &gcd_perf, double &binary_gcd_perf) {
+    std::vector<uint32_t> values(num_iterations * 2);
+    for (auto &v : values) v = rng.next() >> 1;
+
+    {
+        uint64_t sum_sink = 0;
+        const double start_time = TCTimer::get_time();
+        for (uint64_t i=0; i<num_iterations; ++i) sum_sink += tc_math::gcd(int(values[2*i]), int(values[2*i+1]));
+        const double end_time = TCTimer::get_time();
+        DBN(sum_sink)
+        gcd_perf = (end_time - start_time) / num_iterations;
+    }
+    {
+        uint64_t sum_sink = 0;
+        const double start_time = TCTimer::get_time();
+        for (uint64_t i=0; i<num_iterations; ++i) sum_sink += tc_math::binary_gcd(values[2*i], values[2*i+1]);
+        const double end_time = TCTimer::get_time();
+        DBN(sum_sink)
+        binary_gcd_perf = (end_time - start_time) / num_iterations;
+    }
+}
+
+int main(void)
+{
+    DBN(platform_info::get_cpu_brand_string())
+    DBN(platform_info::get_compiler())
+
+    const double EXP_TSC_FREQ = 2.89992e+09; // Doesn't really matter when using get_time() aot get_tsc_time().
+    TCTimer::init_timer(EXP_TSC_FREQ);
+
+    std::cout << "Number of errors = " << test_correctness(10000000) << "\n";
+    std::cout.flush();
+
+    std::vector<uint32_t> hashes(1000000);
+    for (auto &h : hashes) h = rng.next();
+    const uint32_t num_buckets = 1000003 + rng.next(2); // Not known at compile time.
+
+    const double mod_perf = test_mod_perf(hashes, num_buckets);
+    const double fast_mod_perf = test_fast_mod_perf(hashes, num_buckets);
+
+    double gcd_perf, binary_gcd_perf;
+    test_gcd_perf(10000000, gcd_perf, binary_gcd_perf);
+
+    std::cout << "\n";
+    std::cout << "mod_perf = " << mod_perf << " s/call \n";
+    std::cout << "fast_mod_perf = " << fast_mod_perf << " s/call \n";
+    std::cout << "gcd_perf = " << gcd_perf << " s/call \n";
+    std::cout << "binary_gcd_perf = " << binary_gcd_perf << " s/call \n";
+
+    std::cout.flush();
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "../defines/tc_defines.h"
+
+#include "../math/min_max_clamp_between.h"
+#include "../time/tc_timer.h"
+#include "../random/tc_random_funcs.h"
+#include "../platform_info/platform_info.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+TCRandom<TC_MCG_Lehmer_RandFunc32> rng(987654321); // Generally good fast generator.
+
+const size_t array_size = 1000000;
+const int num_repeats = 100;
+
+//! Time a kernel. Returns seconds per element.
+template<class F>
+double time_kernel(F kernel) {
+    const double start_time = TCTimer::get_time();
+    for (int r=0; r<num_repeats; ++r) kernel();
+    const double end_time = TCTimer::get_time();
+    return (end_time - start_time) / (double(num_repeats) * array_size);
+}
+
+//! Fill the data set: sorted, random or adversarial. Values are spread over [0, 1000).
+template<typename T>
+void generate_data(std::vector<T> &data, const std::string &data_set) {
+    for (size_t i=0; i<data.size(); ++i) data[i] = T(rng.next_double(0.0, 1000.0));
+
+    if (data_set == "sorted") {
+        std::sort(data.begin(), data.end());
+    } else if (data_set == "adversarial") {
+        // Descending with a new min/max at random positions, and clamp bounds crossed at random.
+        for (size_t i=0; i<data.size(); ++i) {
+            if (rng.next_boolean()) data[i] = T(1000.0 * (data.size() - i) / data.size());
+        }
+    }
+}
+
+//! argmin/argmax against the scalar first index, for every length up to a few vector widths and values with many ties.
+template<typename T>
+bool check_arg_extreme(const std::string &type_name) {
+    bool ok = true;
+    std::vector<T> data;
+
+    for (size_t n=1; n<=67; ++n) {
+        for (int trial=0; trial<100; ++trial) {
+            data.resize(n);
+            const int num_distinct = (trial & 1) ? 3 : 1000;
+            for (size_t i=0; i<n; ++i) data[i] = T(int(rng.next(num_distinct)) - num_distinct / 2);
+
+            size_t expected_min = 0, expected_max = 0;
+            for (size_t i=1; i<n; ++i) {
+                if (data[i] < data[expected_min]) expected_min = i;
+                if (data[i] > data[expected_max]) expected_max = i;
+            }
+
+            if ((min_max_simd::argmin(data.data(), n) != expected_min) || (min_max_simd::argmax(data.data(), n) != expected_max)) {
+                ok = false;
+            }
+        }
+    }
+
+    std::cout << type_name << " argmin/argmax: " << (ok ? "OK" : "MISMATCH!") << "\n";
+    return ok;
+}
+
+template<typename T>
+void test_type(const std::string &type_name, const std::string &data_set) {
+    std::vector<T> data(array_size), out(array_size);
+    generate_data(data, data_set);
+    const T l = T(250), u = T(750);
+
+    size_t scalar_sink = 0, simd_sink = 0;
+
+    const double scalar_clamp = time_kernel([&]() {
+        for (size_t i=0; i<array_size; ++i) out[i] = clamp(data[i], l, u);
+        scalar_sink += size_t(out[array_size >> 1]);
+    });
+    const double simd_clamp = time_kernel([&]() {
+        min_max_simd::clamp_array(data.data(), out.data(), array_size, l, u);
+        simd_sink += size_t(out[array_size >> 1]);
+    });
+
+    const double scalar_minmax = time_kernel([&]() {
+        T mn = data[0], mx = data[0];
+        for (size_t i=1; i<array_size; ++i) {mn = min(mn, data[i]); mx = max(mx, data[i]);}
+        scalar_sink += size_t(mn) + size_t(mx);
+    });
+    const double simd_minmax = time_kernel([&]() {
+        T mn, mx;
+        min_max_simd::minmax_reduce(data.data(), array_size, mn, mx);
+        simd_sink += size_t(mn) + size_t(mx);
+    });
+
+    const double scalar_argmin = time_kernel([&]() {
+        size_t best_i = 0;
+        for (size_t i=1; i<array_size; ++i) if (data[i] < data[best_i]) best_i = i;
+        scalar_sink += best_i;
+    });
+    const double simd_argmin = time_kernel([&]() {
+        simd_sink += min_max_simd::argmin(data.data(), array_size);
+    });
+
+    const double scalar_argmax = time_kernel([&]() {
+        size_t best_i = 0;
+        for (size_t i=1; i<array_size; ++i) if (data[i] > data[best_i]) best_i = i;
+        scalar_sink += best_i;
+    });
+    const double simd_argmax = time_kernel([&]() {
+        simd_sink += min_max_simd::argmax(data.data(), array_size);
+    });
+
+    const double scalar_count = time_kernel([&]() {
+        size_t count = 0;
+        for (size_t i=0; i<array_size; ++i) if (between(data[i], l, u)) ++count;
+        scalar_sink += count;
+    });
+    const double simd_count = time_kernel([&]() {
+        simd_sink += min_max_simd::count_between(data.data(), array_size, l, u);
+    });
+
+    std::cout << type_name << " " << data_set << ": "
+              << "clamp " << scalar_clamp * 1.0e9 << "/" << simd_clamp * 1.0e9 << ", "
+              << "minmax " << scalar_minmax * 1.0e9 << "/" << simd_minmax * 1.0e9 << ", "
+              << "argmin " << scalar_argmin * 1.0e9 << "/" << simd_argmin * 1.0e9 << ", "
+              << "argmax " << scalar_argmax * 1.0e9 << "/" << simd_argmax * 1.0e9 << ", "
+              << "count_between " << scalar_count * 1.0e9 << "/" << simd_count * 1.0e9
+              << " ns/element (scalar/array)"
+              << ((scalar_sink == simd_sink) ? "" : " MISMATCH!") << "\n";
+    std::cout.flush();
+}
+
+int main(void)
+{
+    DBN(platform_info::get_cpu_brand_string())
+    DBN(platform_info::get_compiler())
+
+    const double EXP_TSC_FREQ = 2.89992e+09; // Doesn't really matter when using get_time() aot get_tsc_time().
+    TCTimer::init_timer(EXP_TSC_FREQ);
+
+    const bool args_ok = check_arg_extreme<int32_t>("int32_t") & check_arg_extreme<float>("float") &
+                         check_arg_extreme<double>("double");
+    if (!args_ok) return 1;
+
+    const std::string data_sets[] = {"sorted", "random", "adversarial"};
+
+    for (const std::string &data_set : data_sets) {
+        test_type<int32_t>("int32_t", data_set);
+        test_type<float>("float", data_set);
+        test_type<double>("double", data_set);
+    }
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+#ifndef TC_HUGE_PAGES_H
+#define TC_HUGE_PAGES_H 1
+
+//===========================//
+//=== TC Huge Page Buffer ===//
+//===========================//
+#include "../defines/tc_defines.h"
+
+#include <string>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*!
+ * Page size and NUMA placement for large arrays (benchmark arrays, DP tables) that would otherwise get 4KB pages
+ * on whichever node touches them first.
+ * - PageKind::huge_2mb/huge_1gb map explicit huge pages (MAP_HUGETLB; needs vm.nr_hugepages or
+ *   nr_overcommit_hugepages). transparent_huge maps 2MB aligned memory and asks for THP with MADV_HUGEPAGE.
+ *   small asks for no THP, which gives the 4KB baseline even if THP is set to "always".
+ *   If the requested kind can't be mapped the next smaller one is tried; get_page_kind() reports what was used.
+ * - NumaPolicy::bind/interleave call mbind before the pages are touched. With one node (or no NUMA kernel) it has
+ *   no effect. Node ids up to 63 are supported.
+ * - The memory is zero filled by the kernel, so only trivial types are allowed.
+ * EXAMPLE Usage:
+ *   TCHugePageBuffer<int> buffer(100000000, tc_huge_pages::PageKind::huge_2mb, tc_huge_pages::NumaPolicy::interleave);
+ *   DBN(tc_huge_pages::get_page_kind_name(buffer.get_page_kind()))
+ *   for (size_t i=0; i<buffer.size(); ++i) buffer[i] = i;
+ */
+
+namespace tc_huge_pages {
+    enum class PageKind {small, transparent_huge, huge_2mb, huge_1gb};
+    enum class NumaPolicy {first_touch, bind, interleave};
+
+    constexpr size_t small_page_bytes_ = size_t(1) << 12;
+    constexpr size_t huge_2mb_bytes_ = size_t(1) << 21;
+    constexpr size_t huge_1gb_bytes_ = size_t(1) << 30;
+
+    const char *get_page_kind_name(const PageKind kind) {
+        switch (kind) {
+            case PageKind::small: return "4KB";
+            case PageKind::transparent_huge: return "THP";
+            case PageKind::huge_2mb: return "2MB";
+            case PageKind::huge_1gb: return "1GB";
+        }
+        return "?";
+    }
+
+    ALWAYS_INLINE size_t round_up(const size_t bytes, const size_t page_bytes) noexcept {
+        return (bytes + page_bytes - 1) & ~(page_bytes - 1);
+    }
+
+    //! Bit mask of the online NUMA nodes (from sysfs, e.g. "0-3,6"). Node 0 only if unknown.
+    uint64_t get_online_numa_nodes() {
+        std::ifstream online_file("/sys/devices/system/node/online");
+        std::string ranges;
+        if (!(online_file >> ranges)) return 1;
+
+        uint64_t mask = 0;
+        size_t pos = 0;
+        while (pos < ranges.size()) {
+            const size_t end = std::min(ranges.find(',', pos), ranges.size());
+            const std::string range = ranges.substr(pos, end - pos);
+            const size_t dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int node=first; (node<=last) && (node<64); ++node) mask |= uint64_t(1) << node;
+            pos = end + 1;
+        }
+        return (mask != 0) ? mask : 1;
+    }
+
+    int get_num_numa_nodes() {return __builtin_popcountll(get_online_numa_nodes());}
+
+    //! Set the NUMA policy of not yet touched pages. Returns false if the kernel refused (e.g. no NUMA support).
+    bool set_numa_policy(void * const p, const size_t bytes, const NumaPolicy policy, const int node = 0) {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (policy == NumaPolicy::first_touch) return true;
+
+        const int mpol_bind = 2, mpol_interleave = 3; //From linux/mempolicy.h.
+        const unsigned long node_mask = (policy == NumaPolicy::bind) ? (1ul << node) : get_online_numa_nodes();
+        const unsigned long max_node = sizeof(node_mask) * 8 + 1; //The kernel reads max_node - 1 bits.
+
+        return syscall(SYS_mbind, p, bytes, (policy == NumaPolicy::bind) ? mpol_bind : mpol_interleave,
+                       &node_mask, max_node, 0) == 0;
+#else
+        (void)p; (void)bytes; (void)node;
+        return policy == NumaPolicy::first_touch;
+#endif
+    }
+
+    //! An anonymous mapping and the page kind that was used.
+    struct Mapping {
+        void *p_ = nullptr;
+        size_t bytes_ = 0; //!< Mapped bytes, a multiple of the page size.
+        PageKind kind_ = PageKind::small;
+    };
+
+    //! Map bytes with the requested page kind, falling back to the next smaller kind.
+    Mapping map_pages(const size_t bytes, PageKind kind) {
+        Mapping m;
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+        if (kind == PageKind::huge_1gb) {
+            const size_t mapped_bytes = round_up(bytes, huge_1gb_bytes_);
+            void * const p = mmap(nullptr, mapped_bytes, prot, flags | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+            if (p != MAP_FAILED) {m.p_ = p; m.bytes_ = mapped_bytes; m.kind_ = kind; return m;}
+            kind = PageKind::huge_2mb;
+        }
+        if (kind == PageKind::huge_2mb) {
+            const size_t mapped_bytes = round_up(bytes, huge_2mb_bytes_);
+            void * const p = mmap(nullptr, mapped_bytes, prot, flags | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+            if (p != MAP_FAILED) {m.p_ = p; m.bytes_ = mapped_bytes; m.kind_ = kind; return m;}
+            kind = PageKind::transparent_huge;
+        }
+#else
+        if (kind != PageKind::small) kind = PageKind::transparent_huge;
+#endif
+
+#ifdef MADV_HUGEPAGE
+        if (kind == PageKind::transparent_huge) {
+            // Over-map by 2MB and trim so that the start is 2MB aligned and every page can be a huge page.
+            const size_t mapped_bytes = round_up(bytes, huge_2mb_bytes_);
+            char * const p = static_cast<char *>(mmap(nullptr, mapped_bytes + huge_2mb_bytes_, prot, flags, -1, 0));
+            if (p != MAP_FAILED) {
+                char * const aligned = reinterpret_cast<char *>(round_up(reinterpret_cast<uintptr_t>(p), huge_2mb_bytes_));
+                const size_t head_bytes = aligned - p;
+                if (head_bytes > 0) munmap(p, head_bytes);
+                munmap(aligned + mapped_bytes, huge_2mb_bytes_ - head_bytes);
+                madvise(aligned, mapped_bytes, MADV_HUGEPAGE);
+                m.p_ = aligned; m.bytes_ = mapped_bytes; m.kind_ = kind;
+                return m;
+            }
+        }
+#endif
+
+        const size_t mapped_bytes = round_up(bytes, small_page_bytes_);
+        void * const p = mmap(nullptr, mapped_bytes, prot, flags, -1, 0);
+        if (p == MAP_FAILED) return m;
+#ifdef MADV_NOHUGEPAGE
+        madvise(p, mapped_bytes, MADV_NOHUGEPAGE);
+#endif
+        m.p_ = p; m.bytes_ = mapped_bytes; m.kind_ = PageKind::small;
+        return m;
+    }
+}
+
+//! Fixed size array of trivial elements in (huge) pages with a NUMA policy. Not copyable; movable.
+template<class T>
+class TCHugePageBuffer {
+    static_assert(std::is_trivial<T>::value, "TCHugePageBuffer elements are zero filled, not constructed.");
+
+public:
+    TCHugePageBuffer() noexcept {}
+
+    TCHugePageBuffer(const size_t n,
+                     const tc_huge_pages::PageKind kind = tc_huge_pages::PageKind::transparent_huge,
+                     const tc_huge_pages::NumaPolicy numa_policy = tc_huge_pages::NumaPolicy::first_touch,
+                     const int numa_node = 0) {
+        allocate(n, kind, numa_policy, numa_node);
+    }
+
+    ~TCHugePageBuffer() {release();}
+
+    TCHugePageBuffer(const TCHugePageBuffer &) = delete;
+    TCHugePageBuffer &operator=(const TCHugePageBuffer &) = delete;
+
+    TCHugePageBuffer(TCHugePageBuffer &&other) noexcept {swap(other);}
+    TCHugePageBuffer &operator=(TCHugePageBuffer &&other) noexcept {
+        if (this != &other) {release(); swap(other);}
+        return *this;
+    }
+
+    void swap(TCHugePageBuffer &other) noexcept {
+        std::swap(mapping_, other.mapping_);
+        std::swap(size_, other.size_);
+        std::swap(numa_policy_applied_, other.numa_policy_applied_);
+    }
+
+    //! Returns false if the memory could not be mapped at all. See get_page_kind() for what was used.
+    bool allocate(const size_t n,
+                  const tc_huge_pages::PageKind kind = tc_huge_pages::PageKind::transparent_huge,
+                  const tc_huge_pages::NumaPolicy numa_policy = tc_huge_pages::NumaPolicy::first_touch,
+                  const int numa_node = 0) {
+        release();
+        mapping_ = tc_huge_pages::map_pages(std::max(n, size_t(1)) * sizeof(T), kind);
+        if (mapping_.p_ == nullptr) return false;
+
+        size_ = n;
+        numa_policy_applied_ = tc_huge_pages::set_numa_policy(mapping_.p_, mapping_.bytes_, numa_policy, numa_node);
+        return true;
+    }
+
+    void release() noexcept {
+        if (mapping_.p_ != nullptr) munmap(mapping_.p_, mapping_.bytes_);
+        mapping_ = tc_huge_pages::Mapping();
+        size_ = 0;
+        numa_policy_applied_ = false;
+    }
+
+    ALWAYS_INLINE T *data() noexcept {return static_cast<T *>(mapping_.p_);}
+    ALWAYS_INLINE const T *data() const noexcept {return static_cast<const T *>(mapping_.p_);}
+    ALWAYS_INLINE T &operator[](const size_t i) noexcept {return data()[i];}
+    ALWAYS_INLINE const T &operator[](const size_t i) const noexcept {return data()[i];}
+    ALWAYS_INLINE T *begin() noexcept {return data();}
+    ALWAYS_INLINE T *end() noexcept {return data() + size_;}
+    ALWAYS_INLINE const T *begin() const noexcept {return data();}
+    ALWAYS_INLINE const T *end() const noexcept {return data() + size_;}
+
+    ALWAYS_INLINE size_t size() const noexcept {return size_;}
+    ALWAYS_INLINE size_t get_mapped_bytes() const noexcept {return mapping_.bytes_;}
+    ALWAYS_INLINE tc_huge_pages::PageKind get_page_kind() const noexcept {return mapping_.kind_;}
+    ALWAYS_INLINE bool is_numa_policy_applied() const noexcept {return numa_policy_applied_;}
+
+private:
+    tc_huge_pages::Mapping mapping_;
+    size_t size_ = 0;
+    bool numa_policy_applied_ = false;
+};
+
+#endif //TC_HUGE_PAGES_H
@@ -0,0 +1,100 @@
+#ifndef TC_PERF_COUNTER_H
+#define TC_PERF_COUNTER_H 1
+
+//===========================//
+//=== TC Perf Counter =======//
+//===========================//
+#include "../defines/tc_defines.h"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * Hardware event counter for the calling thread (user space only) through perf_event_open. Used by the benchmarks
+ * to report e.g. dTLB misses next to the timings.
+ * - is_available() is false if the kernel or the VM doesn't expose the event (or perf_event_paranoid forbids it),
+ *   in which case stop() returns 0. Benchmarks should print "n/a" then.
+ * - page_faults is a software event, so it is usually available in VMs that don't expose the hardware counters.
+ * EXAMPLE Usage:
+ *   TCPerfCounter dtlb_misses(TCPerfCounter::Event::dtlb_load_misses);
+ *   dtlb_misses.start();
+ *   ... //Random access phase.
+ *   const uint64_t num_misses = dtlb_misses.stop();
+ */
+class TCPerfCounter {
+public:
+    enum class Event {cycles, instructions, cache_misses, dtlb_load_misses, dtlb_store_misses, page_faults};
+
+    explicit TCPerfCounter(const Event event) {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        switch (event) {
+            case Event::cycles: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case Event::instructions: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case Event::cache_misses: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case Event::dtlb_load_misses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case Event::dtlb_store_misses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_WRITE << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case Event::page_faults: attr.type = PERF_TYPE_SOFTWARE; attr.config = PERF_COUNT_SW_PAGE_FAULTS; break;
+        }
+
+        fd_ = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0)); //This thread, any CPU.
+#else
+        (void)event;
+#endif
+    }
+
+    ~TCPerfCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    TCPerfCounter(const TCPerfCounter &) = delete;
+    TCPerfCounter &operator=(const TCPerfCounter &) = delete;
+
+    ALWAYS_INLINE bool is_available() const noexcept {return fd_ >= 0;}
+
+    //! Reset and start counting.
+    void start() noexcept {
+#ifdef __linux__
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    //! Stop counting and return the count since start().
+    uint64_t stop() noexcept {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd_ < 0) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != ssize_t(sizeof(count))) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+#endif //TC_PERF_COUNTER_H